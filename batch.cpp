@@ -0,0 +1,70 @@
+#include "batch.h"
+
+using namespace std;
+
+void PlayerBatch::resize(int n)
+{
+    x.resize(n, spawnPoint.x);
+    y.resize(n, spawnPoint.y);
+    xVelocity.resize(n, 0);
+    yVelocity.resize(n, 0);
+    anchorX.resize(n, 0);
+    anchorY.resize(n, 0);
+    ropeLength.resize(n, 0);
+    ropeAngle.resize(n, 0);
+    angularVelocity.resize(n, 0);
+    swinging.resize(n, 0);
+    canJump.resize(n, 1);
+}
+
+void PlayerBatch::load(int i, Player &p) const
+{
+    p.position = {x[i], y[i]};
+    p.xVelocity = xVelocity[i];
+    p.yVelocity = yVelocity[i];
+    p.anchor = {anchorX[i], anchorY[i]};
+    p.ropeLength = ropeLength[i];
+    p.ropeAngle = ropeAngle[i];
+    p.angularVelocity = angularVelocity[i];
+    p.swinging = swinging[i];
+    p.canJump = canJump[i];
+    p.landed = false;
+}
+
+void PlayerBatch::store(int i, const Player &p)
+{
+    x[i] = p.position.x;
+    y[i] = p.position.y;
+    xVelocity[i] = p.xVelocity;
+    yVelocity[i] = p.yVelocity;
+    anchorX[i] = p.anchor.x;
+    anchorY[i] = p.anchor.y;
+    ropeLength[i] = p.ropeLength;
+    ropeAngle[i] = p.ropeAngle;
+    angularVelocity[i] = p.angularVelocity;
+    swinging[i] = p.swinging;
+    canJump[i] = p.canJump;
+}
+
+BatchSimulation::BatchSimulation(const Simulation &sim, ThreadPool &threads)
+    : level(sim), pool(threads), scratch(threads.size())
+{
+}
+
+void BatchSimulation::step(PlayerBatch &batch, const vector<InputState> &inputs, float deltaTime,
+                           vector<StepEvents> *events)
+{
+    if (events) events->resize(batch.size());
+
+    pool.parallelFor(batch.size(), grain, [&](int begin, int end, int worker)
+    {
+        Player &p = scratch[worker];
+        for (int i = begin; i < end; ++i)
+        {
+            batch.load(i, p);
+            StepEvents e = level.stepPlayer(p, inputs[i], deltaTime);
+            batch.store(i, p);
+            if (events) (*events)[i] = e;
+        }
+    });
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "simulation.h"
+#include "threadpool.h"
+
+// State of many independent players in one level, one array per field
+class PlayerBatch
+{
+    public:
+        std::vector<float> x, y;
+        std::vector<float> xVelocity, yVelocity;
+        std::vector<float> anchorX, anchorY;
+        std::vector<float> ropeLength, ropeAngle, angularVelocity;
+        std::vector<uint8_t> swinging, canJump;
+
+        int size() const { return (int)x.size(); }
+
+        // New players start at the spawn point, at rest
+        void resize(int n);
+
+        void load(int i, Player &p) const;
+        void store(int i, const Player &p);
+};
+
+// Steps a PlayerBatch against one level with the same rules as Simulation::step,
+// spreading contiguous runs of players over a thread pool
+class BatchSimulation
+{
+    public:
+        const Simulation &level;
+        ThreadPool &pool;
+        int grain = 256;
+
+        BatchSimulation(const Simulation &sim, ThreadPool &threads);
+
+        // inputs holds one entry per player; events, if given, is filled the same way
+        void step(PlayerBatch &batch, const std::vector<InputState> &inputs, float deltaTime,
+                  std::vector<StepEvents> *events = nullptr);
+
+    private:
+        std::vector<Player> scratch; // one per worker, holds its collision buffers
+};
@@ -0,0 +1,71 @@
+// Throughput of the batched stepper: many players in one level across a thread pool.
+// Build: g++ -O2 -std=c++17 -pthread bench/batch_bench.cpp simulation.cpp mappedfile.cpp parallelload.cpp batch.cpp -o batch_bench
+// Usage: batch_bench [threads] [players] [level]
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include "../batch.h"
+
+using namespace std;
+
+// cheap deterministic per-player input script
+InputState scriptedInput(int player, int step, const PlayerBatch &batch)
+{
+    unsigned h = (unsigned)player * 2654435761u ^ (unsigned)(step / 60) * 40503u;
+    InputState input;
+    input.direction = (int)(h % 3) - 1;
+    input.jump = (h >> 4) % 7 == 0;
+    input.hook = (step + player) % 240 == 0;
+    input.hookTarget = {batch.x[player] + (float)((h >> 8) % 600) - 300, batch.y[player] - 600};
+    input.release = (step + player) % 240 == 150;
+    return input;
+}
+
+int main(int argc, char **argv)
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 0;
+    int players = argc > 2 ? atoi(argv[2]) : 8192;
+    string levelPath = argc > 3 ? argv[3] : "levels/tutorial.json";
+    const int steps = 500;
+    const float fixedStep = 1.0f / 120;
+
+    Simulation level;
+    if (!level.loadFromJson(levelPath))
+    {
+        cerr << "could not load " << levelPath << endl;
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    BatchSimulation sim(level, pool);
+    PlayerBatch batch;
+    batch.resize(players);
+
+    // the same players stepped one at a time, to check the batch follows Simulation's rules
+    const int checked = 16;
+    vector<Player> reference(checked);
+
+    vector<InputState> inputs(players);
+    auto t0 = chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s)
+    {
+        for (int i = 0; i < players; ++i) inputs[i] = scriptedInput(i, s, batch);
+        for (int i = 0; i < checked; ++i) level.stepPlayer(reference[i], inputs[i], fixedStep);
+        sim.step(batch, inputs, fixedStep);
+    }
+    auto t1 = chrono::steady_clock::now();
+
+    int mismatches = 0;
+    for (int i = 0; i < checked; ++i)
+    {
+        if (reference[i].position.x != batch.x[i] || reference[i].position.y != batch.y[i]) mismatches++;
+    }
+
+    double seconds = chrono::duration<double>(t1 - t0).count();
+    double rate = (double)players * steps / seconds;
+    printf("%d players x %d steps on %d threads: %.2f M player-steps/s, %.2f M per thread%s\n",
+           players, steps, pool.size(), rate / 1e6, rate / 1e6 / pool.size(),
+           mismatches ? "  MISMATCH vs serial" : "");
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Per-step broadphase cost of the player against levels of growing size.
+// Build: g++ -O2 -std=c++17 bench/collision_bench.cpp -o collision_bench
+// (add -mavx2 to test the 8-wide overlap kernel)
+#include <iostream>
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <random>
+#include "../collision.h"
+
+using namespace std;
+
+const float playerSize = 50;
+
+int main()
+{
+    const int queries = 200000;
+    mt19937 rng(1234);
+
+    cout << "platforms     linear ns/step     grid ns/step     grid+simd ns/step" << endl;
+    for (int n : {10, 100, 1000, 10000, 100000})
+    {
+        // keep the density constant so the player sees a similar neighbourhood at every size
+        float extent = sqrtf((float)n) * 400.0f;
+        uniform_real_distribution<float> coord(0, extent);
+
+        vector<Rectangle> plats;
+        SpatialGrid grid;
+        RectSoA store;
+        for (int i = 0; i < n; ++i)
+        {
+            plats.push_back({coord(rng), coord(rng), 150, 30});
+            grid.insert(i, plats.back());
+            store.push(plats.back());
+        }
+
+        vector<Rectangle> players;
+        for (int i = 0; i < 1024; ++i)
+            players.push_back({coord(rng), coord(rng), playerSize, playerSize});
+
+        int linearQueries = n >= 10000 ? queries / 100 : queries;
+        long hitsLinear = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (int q = 0; q < linearQueries; ++q)
+        {
+            Rectangle p = players[q & 1023];
+            for (auto &r : plats) hitsLinear += rectsOverlap(p, r);
+        }
+        auto t1 = chrono::steady_clock::now();
+
+        long hitsGrid = 0;
+        vector<int> nearby;
+        for (int q = 0; q < queries; ++q)
+        {
+            Rectangle p = players[q & 1023];
+            grid.query(p, nearby);
+            for (int i : nearby) hitsGrid += rectsOverlap(p, plats[i]);
+        }
+        auto t2 = chrono::steady_clock::now();
+
+        long hitsSimd = 0;
+        RectSoA nearbyRects;
+        for (int q = 0; q < queries; ++q)
+        {
+            Rectangle p = players[q & 1023];
+            grid.query(p, nearby);
+            nearbyRects.gather(store, nearby);
+            for (int base = 0; base < nearbyRects.count; base += overlapLanes)
+                hitsSimd += __builtin_popcount(overlapMask(nearbyRects, base, p));
+        }
+        auto t3 = chrono::steady_clock::now();
+
+        double linearNs = chrono::duration<double, nano>(t1 - t0).count() / linearQueries;
+        double gridNs = chrono::duration<double, nano>(t2 - t1).count() / queries;
+        double simdNs = chrono::duration<double, nano>(t3 - t2).count() / queries;
+        printf("%9d %18.1f %16.1f %21.1f   (hits %ld/%ld/%ld)\n", n, linearNs, gridNs, simdNs,
+               hitsLinear * queries / linearQueries, hitsGrid, hitsSimd);
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Level loading: the single-pass parser against the std::regex loader it replaced,
+// the chunked streaming reader and the mapped binary format, on a generated level of
+// 100k objects, and a load whose collision grids come from the derived-data cache.
+// Build: g++ -O2 -std=c++17 -pthread bench/level_load_bench.cpp simulation.cpp mappedfile.cpp parallelload.cpp -o level_load_bench
+// Usage: level_load_bench [objects]
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <regex>
+#include <fstream>
+#include <random>
+#include <filesystem>
+#include "../simulation.h"
+
+using namespace std;
+
+// The previous Simulation::loadFromJson, kept for comparison. It builds the index the
+// other loaders do, so the same compile time can be taken off every one of them.
+bool loadWithRegex(Simulation &sim, const string &path)
+{
+    ifstream in(path);
+    if (!in.is_open()) return false;
+    string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+
+    regex platformRegex("\\{\"x\":(.*?),\"y\":(.*?),\"w\":(.*?),\"h\":(.*?),\"visible\":(true|false)\\}");
+    sregex_iterator pit(content.begin(), content.end(), platformRegex);
+    sregex_iterator end;
+    vector<platform> newPlats;
+    for (; pit != end; ++pit)
+        newPlats.emplace_back(stof((*pit)[1].str()), stof((*pit)[2].str()), stof((*pit)[3].str()),
+                              stof((*pit)[4].str()), (*pit)[5].str() == "true");
+
+    regex spikeRegex("\\{\"x\":(.*?),\"y\":(.*?),\"size\":(.*?)\\}");
+    sregex_iterator sit(content.begin(), content.end(), spikeRegex);
+    vector<Spike> newSpikes;
+    for (; sit != end; ++sit)
+        newSpikes.emplace_back(stof((*sit)[1].str()), stof((*sit)[2].str()), stof((*sit)[3].str()));
+
+    regex endRegex("\\{\"x\":(.*?),\"y\":(.*?),\"w\":(.*?),\"h\":(.*?),\"toMenu\":(true|false)\\}");
+    sregex_iterator eit(content.begin(), content.end(), endRegex);
+    vector<EndPoint> newEnds;
+    for (; eit != end; ++eit)
+        newEnds.emplace_back(stof((*eit)[1].str()), stof((*eit)[2].str()), stof((*eit)[3].str()),
+                             stof((*eit)[4].str()), (*eit)[5].str() == "true");
+
+    sim.platforms = std::move(newPlats);
+    sim.spikes = std::move(newSpikes);
+    sim.endPoints = std::move(newEnds);
+    sim.compileCollision();
+    return true;
+}
+
+bool sameLevel(const Simulation &a, const Simulation &b)
+{
+    if (a.platforms.size() != b.platforms.size() || a.spikes.size() != b.spikes.size() ||
+        a.endPoints.size() != b.endPoints.size()) return false;
+    for (size_t i = 0; i < a.platforms.size(); ++i)
+    {
+        const platform &p = a.platforms[i], &q = b.platforms[i];
+        if (p.position.x != q.position.x || p.position.y != q.position.y || p.size.x != q.size.x ||
+            p.size.y != q.size.y || p.visible != q.visible) return false;
+    }
+    for (size_t i = 0; i < a.spikes.size(); ++i)
+    {
+        const Spike &p = a.spikes[i], &q = b.spikes[i];
+        if (p.position.x != q.position.x || p.position.y != q.position.y || p.size != q.size) return false;
+    }
+    for (size_t i = 0; i < a.endPoints.size(); ++i)
+    {
+        const EndPoint &p = a.endPoints[i], &q = b.endPoints[i];
+        if (p.position.x != q.position.x || p.position.y != q.position.y || p.size.x != q.size.x ||
+            p.size.y != q.size.y || p.goToMenu != q.goToMenu) return false;
+    }
+    return true;
+}
+
+bool sameGrid(const SpatialGrid &a, const SpatialGrid &b)
+{
+    SpatialGrid::Flat fa, fb;
+    a.flatten(fa);
+    b.flatten(fb);
+    return fa.cellSize == fb.cellSize && fa.slotKeys == fb.slotKeys && fa.slotCells == fb.slotCells &&
+           fa.cellStarts == fb.cellStarts && fa.ids == fb.ids;
+}
+
+template <typename F>
+double timeIt(F &&f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? atoi(argv[1]) : 100000;
+    const string path = "bench_level.json";
+    const string binaryPath = "bench_level.hlvl";
+
+    Simulation source;
+    mt19937 rng(1);
+    uniform_real_distribution<float> coord(-50000, 50000), extent(20, 400);
+    for (int i = 0; i < objects; ++i)
+    {
+        if (i % 10 < 7) source.platforms.emplace_back(coord(rng), coord(rng), extent(rng), extent(rng), i % 5 != 0);
+        else if (i % 10 < 9) source.spikes.emplace_back(coord(rng), coord(rng), 40);
+        else source.endPoints.emplace_back(coord(rng), coord(rng), 60, 60, i % 20 == 9);
+    }
+    source.saveToJson(path);
+    source.saveToBinary(binaryPath);
+
+    Simulation parsed, regexed, streamed, mapped, cached;
+    parsed.useCache = streamed.useCache = mapped.useCache = false;
+    double regexTime = timeIt([&] { loadWithRegex(regexed, path); });
+    double parseTime = 1e30;
+    for (int i = 0; i < 5; ++i) parseTime = min(parseTime, timeIt([&] { parsed.loadFromJson(path, false); }));
+    double streamTime = 1e30;
+    for (int i = 0; i < 5; ++i) streamTime = min(streamTime, timeIt([&] { streamed.streamFromJson(path); }));
+    // the first load fills the cache, the rest hit it
+    cached.loadFromJson(path, false);
+    double cachedTime = 1e30;
+    for (int i = 0; i < 5; ++i) cachedTime = min(cachedTime, timeIt([&] { cached.loadFromJson(path, false); }));
+    double binaryTime = 1e30;
+    for (int i = 0; i < 5; ++i) binaryTime = min(binaryTime, timeIt([&] { mapped.loadFromBinary(binaryPath); }));
+
+    // all of them include compiling the collision index, time that on its own too
+    double compileTime = 1e30;
+    for (int i = 0; i < 5; ++i) compileTime = min(compileTime, timeIt([&] { parsed.compileCollision(); }));
+    remove(path.c_str());
+    remove(binaryPath.c_str());
+    for (auto &entry : filesystem::directory_iterator("cache"))
+        if (entry.path().filename().string().rfind(path + "-", 0) == 0) filesystem::remove(entry.path());
+
+    // both formats store the level exactly, and the cache restores the same grids
+    if (!sameLevel(source, parsed) || !sameLevel(source, regexed) || !sameLevel(source, streamed) ||
+        !sameLevel(source, cached) || !sameLevel(source, mapped) ||
+        !sameGrid(parsed.collision.platforms, cached.collision.platforms) ||
+        !sameGrid(parsed.collision.spikes, cached.collision.spikes))
+    {
+        cerr << "loaders disagree" << endl;
+        return 1;
+    }
+
+    printf("%d objects (%zu platforms, %zu spikes, %zu endpoints)\n", objects,
+           parsed.platforms.size(), parsed.spikes.size(), parsed.endPoints.size());
+    printf("regex loader:  %9.2f ms\n", regexTime * 1000);
+    printf("single pass:   %9.2f ms (%.0fx), of which %.2f ms collision compile\n",
+           parseTime * 1000, regexTime / parseTime, compileTime * 1000);
+    printf("streamed:      %9.2f ms (%.0fx)\n", streamTime * 1000, regexTime / streamTime);
+    printf("cached grids:  %9.2f ms (%.0fx)\n", cachedTime * 1000, regexTime / cachedTime);
+    printf("binary:        %9.2f ms (%.0fx)\n", binaryTime * 1000, regexTime / binaryTime);
+    // a loader left with less than a tenth of the compile is within the noise of timing it
+    auto withoutCompile = [&](const char *name, double loadTime)
+    {
+        if (loadTime - compileTime > compileTime / 10)
+            printf("%s %.0fx", name, (regexTime - compileTime) / (loadTime - compileTime));
+        else printf("%s all compile", name);
+    };
+    printf("without the compile, faster than regex:");
+    withoutCompile(" single pass", parseTime);
+    withoutCompile(", binary", binaryTime);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Level saving: the to_chars serializer against the ofstream writer it replaced, on a
+// generated level of 1M objects. Also checks that a save/load cycle is exact.
+// Build: g++ -O2 -std=c++17 -pthread bench/level_save_bench.cpp simulation.cpp mappedfile.cpp parallelload.cpp -o level_save_bench
+// Usage: level_save_bench [objects]
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <filesystem>
+#include "../simulation.h"
+
+using namespace std;
+
+// The previous Simulation::saveToJson, kept for comparison
+bool saveWithStream(const Simulation &sim, const string &path)
+{
+    ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << "{\n";
+    out << "  \"platforms\": [\n";
+    for (size_t i = 0; i < sim.platforms.size(); ++i)
+    {
+        const platform &p = sim.platforms[i];
+        out << "    {\"x\":" << p.position.x << ",\"y\":" << p.position.y << ",\"w\":" << p.size.x
+            << ",\"h\":" << p.size.y << ",\"visible\":" << (p.visible ? "true" : "false") << "}";
+        if (i + 1 < sim.platforms.size()) out << ",";
+        out << "\n";
+    }
+    out << "  ],\n";
+
+    out << "  \"spikes\": [\n";
+    for (size_t i = 0; i < sim.spikes.size(); ++i)
+    {
+        const Spike &s = sim.spikes[i];
+        out << "    {\"x\":" << s.position.x << ",\"y\":" << s.position.y << ",\"size\":" << s.size << "}";
+        if (i + 1 < sim.spikes.size()) out << ",";
+        out << "\n";
+    }
+    out << "  ]\n";
+
+    out << "  ,\"endpoints\": [\n";
+    for (size_t i = 0; i < sim.endPoints.size(); ++i)
+    {
+        const EndPoint &ep = sim.endPoints[i];
+        out << "    {\"x\":" << ep.position.x << ",\"y\":" << ep.position.y << ",\"w\":" << ep.size.x
+            << ",\"h\":" << ep.size.y << ",\"toMenu\":" << (ep.goToMenu ? "true" : "false") << "}";
+        if (i + 1 < sim.endPoints.size()) out << ",";
+        out << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return (bool)out;
+}
+
+// Number of coordinates that did not survive the round trip
+size_t countDrift(const Simulation &a, const Simulation &b)
+{
+    size_t drift = 0;
+    for (size_t i = 0; i < a.platforms.size(); ++i)
+    {
+        const platform &p = a.platforms[i], &q = b.platforms[i];
+        drift += (p.position.x != q.position.x) + (p.position.y != q.position.y) +
+                 (p.size.x != q.size.x) + (p.size.y != q.size.y);
+    }
+    for (size_t i = 0; i < a.spikes.size(); ++i)
+    {
+        const Spike &p = a.spikes[i], &q = b.spikes[i];
+        drift += (p.position.x != q.position.x) + (p.position.y != q.position.y) + (p.size != q.size);
+    }
+    for (size_t i = 0; i < a.endPoints.size(); ++i)
+    {
+        const EndPoint &p = a.endPoints[i], &q = b.endPoints[i];
+        drift += (p.position.x != q.position.x) + (p.position.y != q.position.y) +
+                 (p.size.x != q.size.x) + (p.size.y != q.size.y);
+    }
+    return drift;
+}
+
+template <typename F>
+double timeIt(F &&f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? atoi(argv[1]) : 1000000;
+    const string path = "bench_level.json";
+
+    Simulation source;
+    mt19937 rng(1);
+    uniform_real_distribution<float> coord(-50000, 50000), extent(20, 400);
+    for (int i = 0; i < objects; ++i)
+    {
+        if (i % 10 < 7) source.platforms.emplace_back(coord(rng), coord(rng), extent(rng), extent(rng), i % 5 != 0);
+        else if (i % 10 < 9) source.spikes.emplace_back(coord(rng), coord(rng), 40);
+        else source.endPoints.emplace_back(coord(rng), coord(rng), 60, 60, i % 20 == 9);
+    }
+
+    Simulation loaded;
+    double streamTime = 1e30, charsTime = 1e30;
+    for (int i = 0; i < 3; ++i) streamTime = min(streamTime, timeIt([&] { saveWithStream(source, path); }));
+    long streamBytes = (long)filesystem::file_size(path);
+    loaded.loadFromJson(path, false);
+    size_t streamDrift = countDrift(source, loaded);
+
+    for (int i = 0; i < 3; ++i) charsTime = min(charsTime, timeIt([&] { source.saveToJson(path); }));
+    long charsBytes = (long)filesystem::file_size(path);
+    loaded.loadFromJson(path, false);
+    size_t charsDrift = countDrift(source, loaded);
+    remove(path.c_str());
+
+    size_t values = source.platforms.size() * 4 + source.spikes.size() * 3 + source.endPoints.size() * 4;
+    printf("%d objects, %zu values\n", objects, values);
+    printf("ofstream:  %8.1f ms  %6.1f MB  %zu values changed by a save/load\n",
+           streamTime * 1000, streamBytes / 1e6, streamDrift);
+    printf("to_chars:  %8.1f ms  %6.1f MB  %zu values changed by a save/load\n",
+           charsTime * 1000, charsBytes / 1e6, charsDrift);
+    printf("%.1fx faster\n", streamTime / charsTime);
+    return charsDrift == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Parsing a large level over 1, 2, 4... threads against the serial parser, checking
+// that every run produces exactly the serial result.
+// Build: g++ -O2 -std=c++17 -pthread bench/parallel_load_bench.cpp parallelload.cpp simulation.cpp mappedfile.cpp -o parallel_load_bench
+// Usage: parallel_load_bench [objects] [max threads]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <thread>
+#include "../parallelload.h"
+#include "../levelparser.h"
+
+using namespace std;
+
+bool same(const platform &a, const platform &b)
+{
+    return a.position.x == b.position.x && a.position.y == b.position.y && a.size.x == b.size.x &&
+           a.size.y == b.size.y && a.visible == b.visible;
+}
+
+bool same(const Spike &a, const Spike &b)
+{
+    return a.position.x == b.position.x && a.position.y == b.position.y && a.size == b.size;
+}
+
+bool same(const EndPoint &a, const EndPoint &b)
+{
+    return a.position.x == b.position.x && a.position.y == b.position.y && a.size.x == b.size.x &&
+           a.size.y == b.size.y && a.goToMenu == b.goToMenu;
+}
+
+template <typename T>
+bool sameRecords(const vector<T> &a, const vector<T> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (!same(a[i], b[i])) return false;
+    return true;
+}
+
+template <typename F>
+double timeIt(F &&f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? atoi(argv[1]) : 2000000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : max(1, (int)thread::hardware_concurrency());
+    const string path = "bench_level.json";
+
+    Simulation source;
+    mt19937 rng(1);
+    uniform_real_distribution<float> coord(-50000, 50000), extent(20, 400);
+    for (int i = 0; i < objects; ++i)
+    {
+        if (i % 10 < 7) source.platforms.emplace_back(coord(rng), coord(rng), extent(rng), extent(rng), i % 5 != 0);
+        else if (i % 10 < 9) source.spikes.emplace_back(coord(rng), coord(rng), 40);
+        else source.endPoints.emplace_back(coord(rng), coord(rng), 60, 60, i % 20 == 9);
+    }
+    source.saveToJson(path);
+    ifstream in(path, ios::binary);
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    remove(path.c_str());
+    const char *begin = text.data(), *end = text.data() + text.size();
+
+    vector<platform> plats;
+    vector<Spike> spks;
+    vector<EndPoint> ends;
+    double serial = 1e30;
+    for (int i = 0; i < 3; ++i)
+    {
+        plats.clear(); spks.clear(); ends.clear();
+        serial = min(serial, timeIt([&] { LevelParser(begin, end).parse(plats, spks, ends); }));
+    }
+    printf("%d objects, %.1f MB of JSON\n", objects, text.size() / 1e6);
+    printf("serial:     %8.1f ms\n", serial * 1000);
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        ThreadPool pool(threads);
+        vector<platform> p;
+        vector<Spike> s;
+        vector<EndPoint> e;
+        double best = 1e30;
+        for (int i = 0; i < 3; ++i)
+        {
+            p.clear(); s.clear(); e.clear();
+            best = min(best, timeIt([&] { parseLevelParallel(begin, end, pool, p, s, e); }));
+        }
+        if (!sameRecords(p, plats) || !sameRecords(s, spks) || !sameRecords(e, ends))
+        {
+            fprintf(stderr, "%d threads: result differs from the serial parser\n", threads);
+            return 1;
+        }
+        printf("%2d threads: %8.1f ms (%.2fx serial)\n", threads, best * 1000, serial / best);
+    }
+    return 0;
+}
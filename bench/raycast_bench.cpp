@@ -0,0 +1,83 @@
+// Cost of a grapple raycast against levels of growing size, grid DDA vs a linear scan.
+// Build: g++ -O2 -std=c++17 bench/raycast_bench.cpp -o raycast_bench
+#include <iostream>
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <random>
+#include "../collision.h"
+
+using namespace std;
+
+const float hookRange = 3000.0f;
+
+int main()
+{
+    const int rays = 200000;
+    mt19937 rng(99);
+    uniform_real_distribution<float> angle(0, 2 * PI);
+
+    cout << "platforms     linear ns/ray     grid ns/ray     hit rate" << endl;
+    for (int n : {100, 1000, 10000, 50000, 100000})
+    {
+        float extent = sqrtf((float)n) * 400.0f;
+        uniform_real_distribution<float> coord(0, extent);
+
+        RectSoA store;
+        SpatialGrid grid;
+        for (int i = 0; i < n; ++i)
+        {
+            Rectangle r = {coord(rng), coord(rng), 150, 30};
+            grid.insert(i, r);
+            store.push(r);
+        }
+
+        vector<Vector2> origins, dirs;
+        for (int i = 0; i < 1024; ++i)
+        {
+            float a = angle(rng);
+            origins.push_back({coord(rng), coord(rng)});
+            dirs.push_back({cosf(a), sinf(a)});
+        }
+
+        int linearRays = n >= 10000 ? rays / 100 : rays / 10;
+        int mismatches = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (int q = 0; q < linearRays; ++q)
+        {
+            Vector2 o = origins[q & 1023], d = dirs[q & 1023];
+            Vector2 inv = {1.0f / d.x, 1.0f / d.y};
+            float best = hookRange;
+            int bestId = -1;
+            for (int i = 0; i < store.count; ++i)
+            {
+                float t;
+                Vector2 normal;
+                if (rayRect(o, inv, store.get(i), t, normal) && t <= best)
+                {
+                    best = t;
+                    bestId = i;
+                }
+            }
+
+            RayHit hit;
+            bool found = grid.raycast(o, d, hookRange, store, hit);
+            if (found != (bestId >= 0) || (found && hit.distance != best)) mismatches++;
+        }
+        auto t1 = chrono::steady_clock::now();
+
+        long hits = 0;
+        for (int q = 0; q < rays; ++q)
+        {
+            RayHit hit;
+            hits += grid.raycast(origins[q & 1023], dirs[q & 1023], hookRange, store, hit);
+        }
+        auto t2 = chrono::steady_clock::now();
+
+        double linearNs = chrono::duration<double, nano>(t1 - t0).count() / linearRays;
+        double gridNs = chrono::duration<double, nano>(t2 - t1).count() / rays;
+        printf("%9d %17.1f %15.1f %11.2f%s\n", n, linearNs, gridNs, (double)hits / rays,
+               mismatches ? "  MISMATCH" : "");
+    }
+    return 0;
+}
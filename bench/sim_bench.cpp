@@ -0,0 +1,46 @@
+// Headless stepping throughput of the simulation core, no window or audio needed.
+// Build: g++ -O2 -std=c++17 -pthread bench/sim_bench.cpp simulation.cpp mappedfile.cpp parallelload.cpp -o sim_bench
+// Run from the repository root so levels/ resolves.
+#include <iostream>
+#include <cstdio>
+#include <chrono>
+#include "../simulation.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    string level = argc > 1 ? argv[1] : "levels/tutorial.json";
+    const int steps = 2000000;
+    const float fixedStep = 1.0f / 120;
+
+    Simulation sim;
+    if (!sim.loadFromJson(level))
+    {
+        cerr << "could not load " << level << endl;
+        return 1;
+    }
+
+    // walk right, hop now and then, and swing from the ceiling every few seconds
+    long events = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (int i = 0; i < steps; ++i)
+    {
+        InputState input;
+        input.direction = (i / 600) % 3 == 2 ? -1 : 1;
+        input.jump = i % 90 == 0;
+        input.hook = i % 720 == 100;
+        input.hookTarget = {sim.player.position.x + 300, sim.player.position.y - 800};
+        input.release = i % 720 == 300;
+
+        StepEvents e = sim.step(input, fixedStep);
+        events += e.hooked + e.released + e.fellOut + (e.endPoint >= 0);
+        if (e.endPoint >= 0) sim.player.respawn();
+    }
+    auto t1 = chrono::steady_clock::now();
+
+    double seconds = chrono::duration<double>(t1 - t0).count();
+    printf("%d steps in %.3f s: %.2f M steps/s (%ld events, final position %.2f, %.2f)\n",
+           steps, seconds, steps / seconds / 1e6, events, sim.player.position.x, sim.player.position.y);
+    return 0;
+}
@@ -0,0 +1,624 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cfloat>
+#include "raylib.h"
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define COLLISION_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define COLLISION_SSE
+#endif
+
+// Same test as raylib's CheckCollisionRecs, inlined so the collision code does not need the raylib library
+inline bool rectsOverlap(Rectangle a, Rectangle b)
+{
+    return a.x < b.x + b.width && a.x + a.width > b.x &&
+           a.y < b.y + b.height && a.y + a.height > b.y;
+}
+
+// Time of impact of a moving along delta against b, as a fraction of delta in [0, 1].
+// Fails if a already overlaps b, moves away from it, or does not reach it this step;
+// normal is the face of b that was hit.
+inline bool sweepRects(Rectangle a, Vector2 delta, Rectangle b, float &toi, Vector2 &normal)
+{
+    float entryX, exitX, entryY, exitY;
+
+    if (delta.x == 0)
+    {
+        if (a.x + a.width <= b.x || a.x >= b.x + b.width) return false;
+        entryX = -INFINITY;
+        exitX = INFINITY;
+    }
+    else if (delta.x > 0)
+    {
+        entryX = (b.x - (a.x + a.width)) / delta.x;
+        exitX = (b.x + b.width - a.x) / delta.x;
+    }
+    else
+    {
+        entryX = (b.x + b.width - a.x) / delta.x;
+        exitX = (b.x - (a.x + a.width)) / delta.x;
+    }
+
+    if (delta.y == 0)
+    {
+        if (a.y + a.height <= b.y || a.y >= b.y + b.height) return false;
+        entryY = -INFINITY;
+        exitY = INFINITY;
+    }
+    else if (delta.y > 0)
+    {
+        entryY = (b.y - (a.y + a.height)) / delta.y;
+        exitY = (b.y + b.height - a.y) / delta.y;
+    }
+    else
+    {
+        entryY = (b.y + b.height - a.y) / delta.y;
+        exitY = (b.y - (a.y + a.height)) / delta.y;
+    }
+
+    float entry = fmaxf(entryX, entryY);
+    float exit = fminf(exitX, exitY);
+    if (entry >= exit || entry < 0 || entry > 1) return false;
+
+    if (entryX > entryY) normal = {delta.x > 0 ? -1.0f : 1.0f, 0};
+    else normal = {0, delta.y > 0 ? -1.0f : 1.0f};
+    toi = entry;
+    return true;
+}
+
+// Bounds of a moving along delta, for broadphase queries of a swept move
+inline Rectangle sweptBounds(Rectangle a, Vector2 delta)
+{
+    return {fminf(a.x, a.x + delta.x), fminf(a.y, a.y + delta.y),
+            a.width + fabsf(delta.x), a.height + fabsf(delta.y)};
+}
+
+struct RayHit
+{
+    Vector2 point;
+    Vector2 normal;
+    float distance;
+    int index;
+};
+
+// Distance along a ray (origin, 1/direction) at which it enters r; rays starting inside r miss
+inline bool rayRect(Vector2 origin, Vector2 invDir, Rectangle r, float &t, Vector2 &normal)
+{
+    float tx1 = (r.x - origin.x) * invDir.x;
+    float tx2 = (r.x + r.width - origin.x) * invDir.x;
+    float ty1 = (r.y - origin.y) * invDir.y;
+    float ty2 = (r.y + r.height - origin.y) * invDir.y;
+
+    float enterX = fminf(tx1, tx2), exitX = fmaxf(tx1, tx2);
+    float enterY = fminf(ty1, ty2), exitY = fmaxf(ty1, ty2);
+    float enter = fmaxf(enterX, enterY);
+    float exit = fminf(exitX, exitY);
+    if (exit < enter || enter < 0) return false;
+
+    if (enterX > enterY) normal = {invDir.x > 0 ? -1.0f : 1.0f, 0};
+    else normal = {0, invDir.y > 0 ? -1.0f : 1.0f};
+    t = enter;
+    return true;
+}
+
+// Number of rectangles overlapMask tests at once
+#if defined(COLLISION_AVX)
+const int overlapLanes = 8;
+#else
+const int overlapLanes = 4;
+#endif
+
+// Structure-of-arrays copy of level rectangles for the overlap kernel.
+// The arrays are padded to a multiple of overlapLanes with rectangles nothing can touch.
+class RectSoA
+{
+    public:
+        std::vector<float> x, y, w, h;
+        int count = 0;
+
+        void clear()
+        {
+            x.clear(); y.clear(); w.clear(); h.clear();
+            count = 0;
+        }
+
+        void resize(int n)
+        {
+            int padded = (n + overlapLanes - 1) / overlapLanes * overlapLanes;
+            for (int i = n; i < count && i < padded; ++i)
+            {
+                x[i] = FLT_MAX; y[i] = FLT_MAX; w[i] = 0; h[i] = 0;
+            }
+            x.resize(padded, FLT_MAX);
+            y.resize(padded, FLT_MAX);
+            w.resize(padded, 0);
+            h.resize(padded, 0);
+            count = n;
+        }
+
+        void push(Rectangle r)
+        {
+            resize(count + 1);
+            set(count - 1, r);
+        }
+
+        void set(int i, Rectangle r)
+        {
+            x[i] = r.x; y[i] = r.y; w[i] = r.width; h[i] = r.height;
+        }
+
+        Rectangle get(int i) const { return {x[i], y[i], w[i], h[i]}; }
+
+        // Copies the listed rectangles of src into this store, in order
+        void gather(const RectSoA &src, const std::vector<int> &ids)
+        {
+            resize((int)ids.size());
+            for (int i = 0; i < count; ++i) set(i, src.get(ids[i]));
+        }
+};
+
+// Tests box against rectangles [base, base + overlapLanes) of r and returns
+// one bit per overlapping rectangle. Same comparisons as rectsOverlap.
+inline unsigned overlapMask(const RectSoA &r, int base, Rectangle box)
+{
+#if defined(COLLISION_AVX)
+    __m256 rx = _mm256_loadu_ps(&r.x[base]);
+    __m256 ry = _mm256_loadu_ps(&r.y[base]);
+    __m256 rr = _mm256_add_ps(rx, _mm256_loadu_ps(&r.w[base]));
+    __m256 rb = _mm256_add_ps(ry, _mm256_loadu_ps(&r.h[base]));
+    __m256 hitX = _mm256_and_ps(_mm256_cmp_ps(_mm256_set1_ps(box.x), rr, _CMP_LT_OQ),
+                                _mm256_cmp_ps(_mm256_set1_ps(box.x + box.width), rx, _CMP_GT_OQ));
+    __m256 hitY = _mm256_and_ps(_mm256_cmp_ps(_mm256_set1_ps(box.y), rb, _CMP_LT_OQ),
+                                _mm256_cmp_ps(_mm256_set1_ps(box.y + box.height), ry, _CMP_GT_OQ));
+    return (unsigned)_mm256_movemask_ps(_mm256_and_ps(hitX, hitY));
+#elif defined(COLLISION_SSE)
+    __m128 rx = _mm_loadu_ps(&r.x[base]);
+    __m128 ry = _mm_loadu_ps(&r.y[base]);
+    __m128 rr = _mm_add_ps(rx, _mm_loadu_ps(&r.w[base]));
+    __m128 rb = _mm_add_ps(ry, _mm_loadu_ps(&r.h[base]));
+    __m128 hitX = _mm_and_ps(_mm_cmplt_ps(_mm_set1_ps(box.x), rr),
+                             _mm_cmpgt_ps(_mm_set1_ps(box.x + box.width), rx));
+    __m128 hitY = _mm_and_ps(_mm_cmplt_ps(_mm_set1_ps(box.y), rb),
+                             _mm_cmpgt_ps(_mm_set1_ps(box.y + box.height), ry));
+    return (unsigned)_mm_movemask_ps(_mm_and_ps(hitX, hitY));
+#else
+    unsigned mask = 0;
+    for (int lane = 0; lane < overlapLanes; ++lane)
+    {
+        if (rectsOverlap(box, r.get(base + lane))) mask |= 1u << lane;
+    }
+    return mask;
+#endif
+}
+
+// Uniform grid over the (unbounded) level, hashed by cell coordinate.
+// Objects are stored by index in every cell their rectangle touches.
+class SpatialGrid
+{
+    public:
+        float cellSize;
+
+        SpatialGrid(float size = 128.0f) { cellSize = size; }
+
+        void clear()
+        {
+            slotKeys.clear();
+            slotCells.clear();
+            cells.clear();
+        }
+
+        void insert(int id, Rectangle r)
+        {
+            int x0, y0, x1, y1;
+            cellRange(r, x0, y0, x1, y1);
+            for (int cy = y0; cy <= y1; ++cy)
+                for (int cx = x0; cx <= x1; ++cx)
+                    cells[findOrAddCell(key(cx, cy))].push_back(id);
+        }
+
+        void remove(int id, Rectangle r)
+        {
+            int x0, y0, x1, y1;
+            cellRange(r, x0, y0, x1, y1);
+            for (int cy = y0; cy <= y1; ++cy)
+            {
+                for (int cx = x0; cx <= x1; ++cx)
+                {
+                    int cell = findCell(key(cx, cy));
+                    if (cell < 0) continue;
+
+                    std::vector<int> &ids = cells[cell];
+                    auto found = std::find(ids.begin(), ids.end(), id);
+                    if (found != ids.end())
+                    {
+                        *found = ids.back();
+                        ids.pop_back();
+                    }
+                }
+            }
+        }
+
+        void move(int id, Rectangle from, Rectangle to)
+        {
+            int ax0, ay0, ax1, ay1, bx0, by0, bx1, by1;
+            cellRange(from, ax0, ay0, ax1, ay1);
+            cellRange(to, bx0, by0, bx1, by1);
+            if (ax0 == bx0 && ay0 == by0 && ax1 == bx1 && ay1 == by1) return;
+
+            remove(id, from);
+            insert(id, to);
+        }
+
+        // Collects the ids of every object sharing a cell with area, sorted ascending
+        // so callers resolve contacts in the same order as a linear scan would.
+        // Queries do not modify the grid, so several threads can share one.
+        void query(Rectangle area, std::vector<int> &out) const
+        {
+            out.clear();
+
+            int x0, y0, x1, y1;
+            cellRange(area, x0, y0, x1, y1);
+            for (int cy = y0; cy <= y1; ++cy)
+            {
+                for (int cx = x0; cx <= x1; ++cx)
+                {
+                    int cell = findCell(key(cx, cy));
+                    if (cell < 0) continue;
+
+                    out.insert(out.end(), cells[cell].begin(), cells[cell].end());
+                }
+            }
+
+            // objects spanning several cells show up once per cell
+            if (out.size() > 1)
+            {
+                std::sort(out.begin(), out.end());
+                out.erase(std::unique(out.begin(), out.end()), out.end());
+            }
+        }
+
+        // Walks the cells along the ray front to back (DDA) and returns the nearest
+        // rectangle of rects it enters within maxDistance. direction must be normalized.
+        bool raycast(Vector2 origin, Vector2 direction, float maxDistance, const RectSoA &rects, RayHit &hit) const
+        {
+            if (direction.x == 0 && direction.y == 0) return false;
+
+            Vector2 invDir = {1.0f / direction.x, 1.0f / direction.y};
+            int cx = (int)floorf(origin.x / cellSize);
+            int cy = (int)floorf(origin.y / cellSize);
+            int stepX = direction.x > 0 ? 1 : -1;
+            int stepY = direction.y > 0 ? 1 : -1;
+            float nextX = direction.x != 0 ? ((cx + (stepX > 0)) * cellSize - origin.x) * invDir.x : INFINITY;
+            float nextY = direction.y != 0 ? ((cy + (stepY > 0)) * cellSize - origin.y) * invDir.y : INFINITY;
+            float deltaX = direction.x != 0 ? cellSize * fabsf(invDir.x) : INFINITY;
+            float deltaY = direction.y != 0 ? cellSize * fabsf(invDir.y) : INFINITY;
+
+            float best = maxDistance;
+            hit.index = -1;
+            float cellEnter = 0;
+            while (cellEnter <= best)
+            {
+                int cell = findCell(key(cx, cy));
+                if (cell >= 0)
+                {
+                    // objects spanning several cells are simply retested, they are hot in cache by then
+                    for (int id : cells[cell])
+                    {
+                        float t;
+                        Vector2 normal;
+                        if (rayRect(origin, invDir, rects.get(id), t, normal) && t <= best)
+                        {
+                            best = t;
+                            hit.index = id;
+                            hit.normal = normal;
+                        }
+                    }
+                }
+
+                if (nextX < nextY)
+                {
+                    cellEnter = nextX;
+                    nextX += deltaX;
+                    cx += stepX;
+                }
+                else
+                {
+                    cellEnter = nextY;
+                    nextY += deltaY;
+                    cy += stepY;
+                }
+            }
+
+            if (hit.index < 0) return false;
+            hit.distance = best;
+            hit.point = {origin.x + direction.x * best, origin.y + direction.y * best};
+            return true;
+        }
+
+        // The grid's tables laid out flat, for storing a built grid and restoring it
+        // later without inserting everything again
+        struct Flat
+        {
+            float cellSize;
+            std::vector<int64_t> slotKeys;
+            std::vector<int> slotCells;
+            std::vector<uint32_t> cellStarts; // cell i holds ids [cellStarts[i], cellStarts[i + 1])
+            std::vector<int> ids;
+        };
+
+        void flatten(Flat &out) const
+        {
+            out.cellSize = cellSize;
+            out.slotKeys = slotKeys;
+            out.slotCells = slotCells;
+            out.cellStarts.clear();
+            out.ids.clear();
+            for (auto &cell : cells)
+            {
+                out.cellStarts.push_back((uint32_t)out.ids.size());
+                out.ids.insert(out.ids.end(), cell.begin(), cell.end());
+            }
+            out.cellStarts.push_back((uint32_t)out.ids.size());
+        }
+
+        // Takes over a flattened grid whose ids are all below idCount. Fails, leaving
+        // the grid as it was, if the tables are inconsistent.
+        bool restore(Flat &&in, int idCount)
+        {
+            size_t slots = in.slotKeys.size();
+            if (in.slotCells.size() != slots || (slots & (slots - 1)) != 0) return false;
+            if (in.cellStarts.empty() || in.cellStarts.front() != 0 || in.cellStarts.back() != in.ids.size()) return false;
+            size_t cellCount = in.cellStarts.size() - 1;
+            // lookups stop at an empty slot, so there must be one
+            if (slots > 0 && cellCount >= slots) return false;
+            for (int cell : in.slotCells)
+                if (cell < -1 || cell >= (int)cellCount) return false;
+            for (size_t i = 0; i < cellCount; ++i)
+                if (in.cellStarts[i] > in.cellStarts[i + 1]) return false;
+            for (int id : in.ids)
+                if (id < 0 || id >= idCount) return false;
+
+            cellSize = in.cellSize;
+            slotKeys = std::move(in.slotKeys);
+            slotCells = std::move(in.slotCells);
+            cells.assign(cellCount, {});
+            for (size_t i = 0; i < cellCount; ++i)
+                cells[i].assign(in.ids.begin() + in.cellStarts[i], in.ids.begin() + in.cellStarts[i + 1]);
+            return true;
+        }
+
+    private:
+        // open-addressing table from cell key to an entry of cells; emptied cells stay allocated
+        std::vector<int64_t> slotKeys;
+        std::vector<int> slotCells;
+        std::vector<std::vector<int>> cells;
+
+        static int64_t key(int cx, int cy)
+        {
+            return (int64_t)(((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy);
+        }
+
+        size_t slotOf(int64_t k) const
+        {
+            return (size_t)(((uint64_t)k * 0x9E3779B97F4A7C15ull) >> 32) & (slotKeys.size() - 1);
+        }
+
+        int findCell(int64_t k) const
+        {
+            if (slotKeys.empty()) return -1;
+            for (size_t slot = slotOf(k); ; slot = (slot + 1) & (slotKeys.size() - 1))
+            {
+                if (slotCells[slot] < 0) return -1;
+                if (slotKeys[slot] == k) return slotCells[slot];
+            }
+        }
+
+        int findOrAddCell(int64_t k)
+        {
+            int cell = findCell(k);
+            if (cell >= 0) return cell;
+
+            // keep the table at most half full
+            if ((cells.size() + 1) * 2 > slotKeys.size())
+            {
+                size_t capacity = slotKeys.empty() ? 64 : slotKeys.size() * 2;
+                std::vector<int64_t> oldKeys = std::move(slotKeys);
+                std::vector<int> oldCells = std::move(slotCells);
+                slotKeys.assign(capacity, 0);
+                slotCells.assign(capacity, -1);
+                for (size_t i = 0; i < oldKeys.size(); ++i)
+                {
+                    if (oldCells[i] >= 0) placeSlot(oldKeys[i], oldCells[i]);
+                }
+            }
+
+            cells.emplace_back();
+            placeSlot(k, (int)cells.size() - 1);
+            return (int)cells.size() - 1;
+        }
+
+        void placeSlot(int64_t k, int cell)
+        {
+            size_t slot = slotOf(k);
+            while (slotCells[slot] >= 0) slot = (slot + 1) & (slotKeys.size() - 1);
+            slotKeys[slot] = k;
+            slotCells[slot] = cell;
+        }
+
+        void cellRange(Rectangle r, int &x0, int &y0, int &x1, int &y1) const
+        {
+            x0 = (int)floorf(r.x / cellSize);
+            y0 = (int)floorf(r.y / cellSize);
+            x1 = (int)floorf((r.x + r.width) / cellSize);
+            y1 = (int)floorf((r.y + r.height) / cellSize);
+        }
+};
+
+// The union of the listed rectangles as rows of cells stacked into the tallest
+// rectangles they allow (columns, if transposed). Empty if the grid would be too big.
+inline std::vector<Rectangle> unionStrips(const std::vector<Rectangle> &rects, const std::vector<int> &group, bool transposed)
+{
+    const size_t maxGridCells = 1 << 22;
+
+    // the union on a grid of every edge coordinate, transposed to run along y
+    auto flip = [transposed](Rectangle r) { return transposed ? Rectangle{r.y, r.x, r.height, r.width} : r; };
+    std::vector<float> xs, ys;
+    for (int i : group)
+    {
+        Rectangle r = flip(rects[i]);
+        xs.push_back(r.x);
+        xs.push_back(r.x + r.width);
+        ys.push_back(r.y);
+        ys.push_back(r.y + r.height);
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    size_t cols = xs.size() - 1, rows = ys.size() - 1;
+    if (cols * rows > maxGridCells) return {};
+
+    // coverage counts by 2D prefix sum over corner marks
+    std::vector<int> cover((cols + 1) * (rows + 1), 0);
+    for (int i : group)
+    {
+        Rectangle r = flip(rects[i]);
+        size_t x0 = std::lower_bound(xs.begin(), xs.end(), r.x) - xs.begin();
+        size_t x1 = std::lower_bound(xs.begin(), xs.end(), r.x + r.width) - xs.begin();
+        size_t y0 = std::lower_bound(ys.begin(), ys.end(), r.y) - ys.begin();
+        size_t y1 = std::lower_bound(ys.begin(), ys.end(), r.y + r.height) - ys.begin();
+        cover[y0 * (cols + 1) + x0]++;
+        cover[y0 * (cols + 1) + x1]--;
+        cover[y1 * (cols + 1) + x0]--;
+        cover[y1 * (cols + 1) + x1]++;
+    }
+    for (size_t y = 0; y <= rows; ++y)
+        for (size_t x = 0; x <= cols; ++x)
+        {
+            int &c = cover[y * (cols + 1) + x];
+            if (x > 0) c += cover[y * (cols + 1) + x - 1];
+            if (y > 0) c += cover[(y - 1) * (cols + 1) + x];
+            if (x > 0 && y > 0) c -= cover[(y - 1) * (cols + 1) + x - 1];
+        }
+
+    // runs of covered cells per row; a run identical to one in the row above extends it
+    struct Open { size_t x0, x1, y0; };
+    std::vector<Open> open, next;
+    std::vector<Rectangle> strips;
+    auto close = [&](const Open &o, size_t y)
+    {
+        strips.push_back(flip({xs[o.x0], ys[o.y0], xs[o.x1] - xs[o.x0], ys[y] - ys[o.y0]}));
+    };
+    for (size_t y = 0; y <= rows; ++y)
+    {
+        next.clear();
+        size_t k = 0;
+        for (size_t x = 0; y < rows && x < cols; )
+        {
+            if (cover[y * (cols + 1) + x] <= 0) { ++x; continue; }
+            size_t x0 = x;
+            while (x < cols && cover[y * (cols + 1) + x] > 0) ++x;
+
+            while (k < open.size() && open[k].x0 < x0) close(open[k++], y);
+            if (k < open.size() && open[k].x0 == x0 && open[k].x1 == x) next.push_back(open[k++]);
+            else next.push_back({x0, x, y});
+        }
+        while (k < open.size()) close(open[k++], y);
+        std::swap(open, next);
+    }
+    return strips;
+}
+
+// Replaces rects by a set covering exactly the same area, for geometry that never
+// moves. Groups of overlapping or touching rectangles are redrawn from their union as
+// strips stacked into the largest rectangles they allow, or, when that would take
+// more rectangles, kept minus those lying inside another. Rectangles
+// without area, and groups too large to redraw, pass through.
+inline std::vector<Rectangle> mergeRects(const std::vector<Rectangle> &rects)
+{
+    const size_t maxPruneGroup = 4096;
+
+    int n = (int)rects.size();
+    std::vector<Rectangle> out;
+
+    // union-find over rectangles sharing any point, edges included
+    std::vector<int> parent(n);
+    for (int i = 0; i < n; ++i) parent[i] = i;
+    auto root = [&](int i)
+    {
+        while (parent[i] != i) i = parent[i] = parent[parent[i]];
+        return i;
+    };
+    auto solid = [&](int i) { return rects[i].width > 0 && rects[i].height > 0; };
+
+    // cells about twice the typical rectangle, so most sit in one to four of them
+    double extent = 0;
+    for (const Rectangle &r : rects) extent += std::max(r.width, r.height);
+    SpatialGrid grid(n > 0 ? std::max(64.0f, (float)(2 * extent / n)) : 128.0f);
+    for (int i = 0; i < n; ++i)
+        if (solid(i)) grid.insert(i, rects[i]);
+    std::vector<int> near;
+    for (int i = 0; i < n; ++i)
+    {
+        if (!solid(i))
+        {
+            out.push_back(rects[i]);
+            continue;
+        }
+        const Rectangle &a = rects[i];
+        grid.query(a, near);
+        for (int j : near)
+        {
+            const Rectangle &b = rects[j];
+            if (j != i && a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height)
+                parent[root(i)] = root(j);
+        }
+    }
+
+    std::vector<std::vector<int>> groups(n);
+    for (int i = 0; i < n; ++i)
+        if (solid(i)) groups[root(i)].push_back(i);
+
+    for (auto &group : groups)
+    {
+        if (group.empty()) continue;
+        if (group.size() == 1)
+        {
+            out.push_back(rects[group[0]]);
+            continue;
+        }
+
+        // the group as it is, less rectangles inside another (the first of equal ones stays)
+        std::vector<Rectangle> kept;
+        for (int i : group)
+        {
+            const Rectangle &a = rects[i];
+            bool inside = false;
+            for (size_t k = 0; k < group.size() && !inside && group.size() <= maxPruneGroup; ++k)
+            {
+                int j = group[k];
+                const Rectangle &b = rects[j];
+                inside = j != i && b.x <= a.x && b.y <= a.y && a.x + a.width <= b.x + b.width &&
+                         a.y + a.height <= b.y + b.height &&
+                         (j < i || b.x != a.x || b.y != a.y || b.width != a.width || b.height != a.height);
+            }
+            if (!inside) kept.push_back(a);
+        }
+
+        // the union as strips along x, and along y, whichever takes fewer
+        std::vector<Rectangle> strips = unionStrips(rects, group, false);
+        std::vector<Rectangle> columns = unionStrips(rects, group, true);
+        if (columns.size() < strips.size()) strips.swap(columns);
+
+        if (!strips.empty() && strips.size() < kept.size()) out.insert(out.end(), strips.begin(), strips.end());
+        else out.insert(out.end(), kept.begin(), kept.end());
+    }
+    return out;
+}
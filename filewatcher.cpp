@@ -0,0 +1,178 @@
+#include "filewatcher.h"
+#include <algorithm>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/inotify.h>
+    #include <poll.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+void FileWatcher::noteWritten(const std::string &name)
+{
+    std::string path = directory + "/" + name;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (std::find(pending.begin(), pending.end(), path) == pending.end()) pending.push_back(path);
+    dirty.store(true, std::memory_order_release);
+}
+
+bool FileWatcher::poll(std::vector<std::string> &changed)
+{
+    if (!dirty.load(std::memory_order_acquire)) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    dirty.store(false, std::memory_order_relaxed);
+    changed.insert(changed.end(), pending.begin(), pending.end());
+    pending.clear();
+    return !changed.empty();
+}
+
+#ifdef _WIN32
+
+bool FileWatcher::start(const std::string &dir)
+{
+    stop();
+    HANDLE d = CreateFileA(dir.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (d == INVALID_HANDLE_VALUE) return false;
+
+    HANDLE e = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!e)
+    {
+        CloseHandle(d);
+        return false;
+    }
+
+    directory = dir;
+    handle = d;
+    stopEvent = e;
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void FileWatcher::run()
+{
+    DWORD buffer[4096];
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!overlapped.hEvent) return;
+
+    for (;;)
+    {
+        ResetEvent(overlapped.hEvent);
+        // editors that save in place touch LAST_WRITE, ones that save by rename FILE_NAME
+        if (!ReadDirectoryChangesW((HANDLE)handle, buffer, sizeof(buffer), FALSE,
+                                   FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                                   NULL, &overlapped, NULL)) break;
+
+        HANDLE waits[2] = {overlapped.hEvent, (HANDLE)stopEvent};
+        DWORD bytes = 0;
+        if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0)
+        {
+            CancelIo((HANDLE)handle);
+            GetOverlappedResult((HANDLE)handle, &overlapped, &bytes, TRUE);
+            break;
+        }
+        // no bytes means the buffer overflowed and the changes were lost
+        if (!GetOverlappedResult((HANDLE)handle, &overlapped, &bytes, FALSE) || bytes == 0) continue;
+
+        const unsigned char *at = (const unsigned char *)buffer;
+        for (;;)
+        {
+            const FILE_NOTIFY_INFORMATION *info = (const FILE_NOTIFY_INFORMATION *)at;
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+            {
+                int wide = (int)(info->FileNameLength / sizeof(WCHAR));
+                int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide, NULL, 0, NULL, NULL);
+                std::string name(size, '\0');
+                WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide, &name[0], size, NULL, NULL);
+                noteWritten(name);
+            }
+            if (info->NextEntryOffset == 0) break;
+            at += info->NextEntryOffset;
+        }
+    }
+    CloseHandle(overlapped.hEvent);
+}
+
+void FileWatcher::stop()
+{
+    if (thread.joinable())
+    {
+        SetEvent((HANDLE)stopEvent);
+        thread.join();
+    }
+    if (handle) CloseHandle((HANDLE)handle);
+    if (stopEvent) CloseHandle((HANDLE)stopEvent);
+    handle = nullptr;
+    stopEvent = nullptr;
+}
+
+#else
+
+bool FileWatcher::start(const std::string &dir)
+{
+    stop();
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return false;
+    // written in place, or saved elsewhere and renamed over (as writeFileAtomic does)
+    if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || pipe(stopPipe) != 0)
+    {
+        stop();
+        return false;
+    }
+
+    directory = dir;
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void FileWatcher::run()
+{
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        pollfd fds[2] = {{fd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char *at = buffer; at < buffer + length; )
+            {
+                const inotify_event *event = (const inotify_event *)at;
+                if (event->len > 0 && !(event->mask & IN_ISDIR)) noteWritten(event->name);
+                at += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+}
+
+void FileWatcher::stop()
+{
+    if (thread.joinable())
+    {
+        char wake = 0;
+        ssize_t sent = write(stopPipe[1], &wake, 1);
+        (void)sent;
+        thread.join();
+    }
+    if (fd >= 0) close(fd);
+    if (stopPipe[0] >= 0) close(stopPipe[0]);
+    if (stopPipe[1] >= 0) close(stopPipe[1]);
+    fd = -1;
+    stopPipe[0] = stopPipe[1] = -1;
+}
+
+#endif
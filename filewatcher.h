@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+// Reports files written into a directory, by another program or this one. A background
+// thread sleeps in the OS until something changes: inotify on Linux,
+// ReadDirectoryChangesW on Windows. Kept in its own translation unit without raylib.h,
+// like MappedFile.
+class FileWatcher
+{
+    public:
+        FileWatcher() = default;
+        ~FileWatcher() { stop(); }
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        // Fails if directory cannot be watched, and on platforms without a watcher
+        bool start(const std::string &directory);
+        void stop();
+
+        // Appends the files written since the last call to changed, each once, as
+        // directory/name. Only an atomic load while nothing has changed.
+        bool poll(std::vector<std::string> &changed);
+
+    private:
+        void run();
+        void noteWritten(const std::string &name);
+
+        std::string directory;
+        std::thread thread;
+        std::mutex mutex;
+        std::vector<std::string> pending;
+        std::atomic<bool> dirty{false};
+#ifdef _WIN32
+        void *handle = nullptr;
+        void *stopEvent = nullptr;
+#else
+        int fd = -1;
+        int stopPipe[2] = {-1, -1};
+#endif
+};
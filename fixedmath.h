@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-point arithmetic for the deterministic simulation mode. Only integer
+// operations are used, so results are bit-identical across compilers, optimisation
+// levels, -ffast-math and CPUs. Values are Q.20 in 64 bits; trig, exp and log work
+// in Q.30 internally.
+
+typedef int64_t Fixed;
+
+const int fixedBits = 20;
+const Fixed fixedOne = (Fixed)1 << fixedBits;
+
+const int64_t cordicOne = (int64_t)1 << 30;
+const int64_t cordicPi = 3373259426;
+const int64_t cordicHalfPi = 1686629713;
+const int64_t cordicLn2 = 744261118;
+const int64_t cordicGain = 652032874; // 1 / prod(sqrt(1 + 2^-2i))
+const int cordicIterations = 30;
+const int64_t cordicAngles[cordicIterations] = { // atan(2^-i)
+    843314857, 497837829, 263043837, 133525159, 67021687, 33543516, 16775851, 8388437,
+    4194283, 2097149, 1048576, 524288, 262144, 131072, 65536, 32768,
+    16384, 8192, 4096, 2048, 1024, 512, 256, 128, 64, 32, 16, 8, 4, 2};
+
+const Fixed fixedPi = cordicPi >> 10;
+
+inline Fixed roundShift(int64_t v, int s)
+{
+    return (v + ((int64_t)1 << (s - 1))) >> s;
+}
+
+// Exact for floats on a grid of 2^-20 or coarser, truncates finer ones
+inline Fixed toFixed(float f)
+{
+    return (Fixed)(f * (float)fixedOne);
+}
+
+// Rounds to a grid of 2^-bits that a float holds exactly for magnitudes below 2^(24 - bits)
+inline float toFloat(Fixed v, int bits = 8)
+{
+    int64_t q = bits < fixedBits ? roundShift(v, fixedBits - bits) : v;
+    const int64_t limit = ((int64_t)1 << 24) - 1;
+    if (q > limit) q = limit;
+    if (q < -limit) q = -limit;
+    return (float)q / (float)((int64_t)1 << bits);
+}
+
+inline Fixed fixedMul(Fixed a, Fixed b)
+{
+    return roundShift(a * b, fixedBits);
+}
+
+inline Fixed fixedDiv(Fixed a, Fixed b)
+{
+    return a * fixedOne / b;
+}
+
+inline Fixed fixedAbs(Fixed a)
+{
+    return a < 0 ? -a : a;
+}
+
+inline uint64_t isqrt(uint64_t v)
+{
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > v) bit >>= 2;
+    while (bit)
+    {
+        if (v >= result + bit)
+        {
+            v -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else result >>= 1;
+        bit >>= 2;
+    }
+    return result;
+}
+
+// Length of (x, y); long vectors lose low bits instead of overflowing
+inline Fixed fixedLength(Fixed x, Fixed y)
+{
+    uint64_t ax = fixedAbs(x), ay = fixedAbs(y);
+    int shift = 0;
+    while ((ax | ay) >= ((uint64_t)1 << 30))
+    {
+        ax >>= 1;
+        ay >>= 1;
+        shift++;
+    }
+    return (Fixed)isqrt(ax * ax + ay * ay) << shift;
+}
+
+inline void fixedSinCos(Fixed angle, Fixed &s, Fixed &c)
+{
+    // reduce to [-pi/2, pi/2], the range CORDIC converges over
+    int64_t z = (angle * 1024) % (2 * cordicPi);
+    if (z > cordicPi) z -= 2 * cordicPi;
+    if (z < -cordicPi) z += 2 * cordicPi;
+    bool flip = false;
+    if (z > cordicHalfPi) { z -= cordicPi; flip = true; }
+    else if (z < -cordicHalfPi) { z += cordicPi; flip = true; }
+
+    int64_t x = cordicGain, y = 0;
+    for (int i = 0; i < cordicIterations; ++i)
+    {
+        int64_t dx = x >> i, dy = y >> i;
+        if (z >= 0) { x -= dy; y += dx; z -= cordicAngles[i]; }
+        else        { x += dy; y -= dx; z += cordicAngles[i]; }
+    }
+    if (flip) { x = -x; y = -y; }
+    s = roundShift(y, 10);
+    c = roundShift(x, 10);
+}
+
+inline Fixed fixedAtan2(Fixed y, Fixed x)
+{
+    if (x == 0 && y == 0) return 0;
+
+    // rotate into the right half-plane, then scale up for precision
+    int64_t z = 0;
+    if (x < 0)
+    {
+        int64_t t = x;
+        if (y >= 0) { x = y; y = -t; z = cordicHalfPi; }
+        else        { x = -y; y = t; z = -cordicHalfPi; }
+    }
+    while (fixedAbs(x) < ((int64_t)1 << 40) && fixedAbs(y) < ((int64_t)1 << 40))
+    {
+        x *= 2;
+        y *= 2;
+    }
+
+    for (int i = 0; i < cordicIterations; ++i)
+    {
+        int64_t dx = x >> i, dy = y >> i;
+        if (y > 0) { x += dy; y -= dx; z += cordicAngles[i]; }
+        else       { x -= dy; y += dx; z -= cordicAngles[i]; }
+    }
+    return roundShift(z, 10);
+}
+
+// Natural log of x > 0
+inline Fixed fixedLog(Fixed x)
+{
+    int k = 0;
+    int64_t m = x;
+    while (m >= 2 * fixedOne) { m >>= 1; k++; }
+    while (m < fixedOne) { m *= 2; k--; }
+
+    // ln m = 2 atanh(s), s = (m - 1) / (m + 1) <= 1/3
+    int64_t s = (m - fixedOne) * cordicOne / (m + fixedOne);
+    int64_t s2 = s * s >> 30;
+    int64_t term = s, sum = 0;
+    for (int n = 1; term != 0; n += 2)
+    {
+        sum += term / n;
+        term = term * s2 >> 30;
+    }
+    return roundShift(2 * sum + k * cordicLn2, 10);
+}
+
+inline Fixed fixedExp(Fixed x)
+{
+    // x = n ln2 + r with r in [0, ln2)
+    int64_t xq = x * 1024;
+    int64_t n = xq / cordicLn2;
+    if (xq - n * cordicLn2 < 0) n--;
+    int64_t r = xq - n * cordicLn2;
+
+    int64_t term = cordicOne, sum = cordicOne;
+    for (int i = 1; term != 0; ++i)
+    {
+        term = (term * r >> 30) / i;
+        sum += term;
+    }
+    sum = n >= 0 ? sum << n : sum >> -n;
+    return roundShift(sum, 10);
+}
+
+// base^e for base > 0
+inline Fixed fixedPow(Fixed base, Fixed e)
+{
+    return fixedExp(fixedMul(e, fixedLog(base)));
+}
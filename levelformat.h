@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "mappedfile.h"
+
+// Binary level files (.hlvl): a header, a table of sections and one array of
+// fixed-layout little-endian records per section. Sections are 8-byte aligned
+// and records are read straight out of the mapped file.
+//
+// A section's recordSize may be larger than the record below in later versions;
+// readers stride by recordSize and ignore the fields they do not know.
+
+const char levelMagic[4] = {'H', 'K', 'L', 'V'};
+const uint32_t levelVersion = 1;
+const char *const binaryLevelExtension = ".hlvl";
+
+enum LevelSectionType : uint32_t
+{
+    SECTION_PLATFORMS = 1,
+    SECTION_SPIKES = 2,
+    SECTION_ENDPOINTS = 3
+};
+
+struct LevelFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t sectionCount;
+    uint32_t reserved;
+};
+
+struct LevelSection
+{
+    uint32_t type;
+    uint32_t recordSize;
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct PlatformRecord
+{
+    float x, y, w, h;
+    uint32_t flags; // bit 0: visible
+};
+
+struct SpikeRecord
+{
+    float x, y, size;
+};
+
+struct EndPointRecord
+{
+    float x, y, w, h;
+    uint32_t flags; // bit 0: goes to the menu
+};
+
+static_assert(sizeof(LevelFileHeader) == 16 && sizeof(LevelSection) == 24, "level file layout");
+static_assert(sizeof(PlatformRecord) == 20 && sizeof(SpikeRecord) == 12 && sizeof(EndPointRecord) == 20, "level record layout");
+
+// A mapped .hlvl file, validated on open. Records are read straight from the mapping,
+// which needs a little-endian host; elsewhere open fails and callers fall back to the
+// JSON file. What the mapping saves is the parse and a buffer to read into: the level's
+// objects are still copies of the records (see Simulation::loadFromBinary).
+class LevelFileView
+{
+    public:
+        template <typename T>
+        struct Records
+        {
+            const unsigned char *base = nullptr;
+            size_t stride = 0;
+            size_t count = 0;
+
+            const T &operator[](size_t i) const { return *(const T *)(base + i * stride); }
+        };
+
+        bool open(const std::string &path)
+        {
+            platforms = {};
+            spikes = {};
+            endPoints = {};
+
+            const uint16_t probe = 1;
+            if (*(const unsigned char *)&probe != 1) return false;
+
+            if (!file.open(path) || file.size() < sizeof(LevelFileHeader)) return false;
+            const LevelFileHeader *header = (const LevelFileHeader *)file.data();
+            if (memcmp(header->magic, levelMagic, 4) != 0 || header->version != levelVersion) return false;
+
+            uint64_t tableEnd = sizeof(LevelFileHeader) + (uint64_t)header->sectionCount * sizeof(LevelSection);
+            if (tableEnd > file.size()) return false;
+
+            const LevelSection *sections = (const LevelSection *)(file.data() + sizeof(LevelFileHeader));
+            for (uint32_t i = 0; i < header->sectionCount; ++i)
+            {
+                const LevelSection &s = sections[i];
+                // unknown section types are skipped, known ones must fit in the file
+                if (s.type == SECTION_PLATFORMS && !bind(s, platforms)) return false;
+                if (s.type == SECTION_SPIKES && !bind(s, spikes)) return false;
+                if (s.type == SECTION_ENDPOINTS && !bind(s, endPoints)) return false;
+            }
+            return true;
+        }
+
+        void close() { file.close(); }
+
+        // the whole file
+        const unsigned char *data() const { return file.data(); }
+        size_t size() const { return file.size(); }
+
+        Records<PlatformRecord> platforms;
+        Records<SpikeRecord> spikes;
+        Records<EndPointRecord> endPoints;
+
+    private:
+        MappedFile file;
+
+        template <typename T>
+        bool bind(const LevelSection &s, Records<T> &out)
+        {
+            if (s.recordSize < sizeof(T) || s.offset % 4 != 0 || s.recordSize % 4 != 0) return false;
+            if (s.offset > file.size() || s.count > (file.size() - s.offset) / s.recordSize) return false;
+            out.base = file.data() + s.offset;
+            out.stride = s.recordSize;
+            out.count = (size_t)s.count;
+            return true;
+        }
+};
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cstring>
+#include <istream>
+#include <charconv>
+#include <string_view>
+#include "simulation.h"
+
+// Single-pass reader for the level JSON written by Simulation::saveToJson.
+// Whitespace is free, fields may come in any order and unknown keys are skipped;
+// missing fields keep the object's defaults. Numbers are parsed in place with
+// from_chars, and keys and skipped strings share one buffer, so past the first few
+// keys nothing is allocated besides the output vectors.
+//
+// The input is either all in memory or an istream read a chunk at a time, in which
+// case only the chunk is buffered. The "counts" object saveToJson writes first is
+// used to reserve the output vectors up front.
+class LevelParser
+{
+    public:
+        LevelParser(const char *begin, const char *end) : p(begin), end(end), sizeHint(end - begin) {}
+
+        // size is the length of the input if known, it bounds how much counts may reserve
+        LevelParser(std::istream &in, size_t size, size_t chunkSize = 64 * 1024)
+            : in(&in), buffer(chunkSize), sizeHint(size)
+        {
+            p = end = buffer.data();
+        }
+
+        bool parse(std::vector<platform> &plats, std::vector<Spike> &spks, std::vector<EndPoint> &ends)
+        {
+            bool ok = object([&](std::string_view k)
+            {
+                if (k == "counts") return object([&](std::string_view f)
+                {
+                    size_t n;
+                    if (!integer(n)) return false;
+                    if (f == "platforms") reserve(plats, n);
+                    else if (f == "spikes") reserve(spks, n);
+                    else if (f == "endpoints") reserve(ends, n);
+                    return true;
+                });
+
+                if (k == "platforms") return array([&] { return append(plats); });
+                if (k == "spikes") return array([&] { return append(spks); });
+                if (k == "endpoints") return array([&] { return append(ends); });
+                return skipValue();
+            });
+
+            skipSpace();
+            return ok && p == end;
+        }
+
+        // The records of one of the level arrays, from the first record to the closing bracket
+        struct Span
+        {
+            const char *begin = nullptr;
+            const char *end = nullptr;
+        };
+
+        // Finds the three arrays without parsing them. False if the level is malformed
+        // outside them or an array appears twice. Input in memory only.
+        bool locate(Span &plats, Span &spks, Span &ends)
+        {
+            bool ok = object([&](std::string_view k)
+            {
+                if (k == "platforms") return span(plats);
+                if (k == "spikes") return span(spks);
+                if (k == "endpoints") return span(ends);
+                return skipValue();
+            });
+
+            skipSpace();
+            return ok && p == end;
+        }
+
+        // Parses records from here, which must be the start of one, up to limit. True only
+        // if a record ends exactly at limit, so a chunk that did not start on a record
+        // boundary is caught by the chunk before it. The parser's end is the closing bracket.
+        template <typename T>
+        bool records(const char *limit, std::vector<T> &out)
+        {
+            skipSpace();
+            while (p < limit)
+            {
+                if (!append(out)) return false;
+                if (!consume(',')) return p == end && limit == end;
+                skipSpace();
+                if (p == end) return false;
+            }
+            return p == limit;
+        }
+
+    private:
+        const char *p;
+        const char *end;
+        std::istream *in = nullptr;
+        std::vector<char> buffer;
+        size_t sizeHint;
+        // the last key or skipped string read, kept so its capacity is reused
+        std::string text;
+
+        // Moves the unread bytes to the front of the buffer and reads more behind them,
+        // growing the buffer if it is full. False once the input is used up.
+        bool refill()
+        {
+            if (!in || !*in) return false;
+            size_t left = end - p;
+            if (left == buffer.size()) buffer.resize(buffer.size() * 2);
+            std::memmove(buffer.data(), p, left);
+            in->read(buffer.data() + left, buffer.size() - left);
+            p = buffer.data();
+            end = p + left + in->gcount();
+            return in->gcount() > 0;
+        }
+
+        // Makes n bytes readable at p, or all that are left
+        void ensure(size_t n)
+        {
+            while ((size_t)(end - p) < n && refill()) {}
+        }
+
+        // a count from the file is only a hint, the smallest record is 16 bytes
+        template <typename T>
+        void reserve(std::vector<T> &v, size_t n)
+        {
+            v.reserve(v.size() + std::min(n, sizeHint / 16));
+        }
+
+        bool record(platform &pl)
+        {
+            return object([&](std::string_view f)
+            {
+                if (f == "x") return number(pl.position.x);
+                if (f == "y") return number(pl.position.y);
+                if (f == "w") return number(pl.size.x);
+                if (f == "h") return number(pl.size.y);
+                if (f == "visible") return boolean(pl.visible);
+                return skipValue();
+            });
+        }
+
+        bool record(Spike &s)
+        {
+            return object([&](std::string_view f)
+            {
+                if (f == "x") return number(s.position.x);
+                if (f == "y") return number(s.position.y);
+                if (f == "size") return number(s.size);
+                return skipValue();
+            });
+        }
+
+        bool record(EndPoint &e)
+        {
+            return object([&](std::string_view f)
+            {
+                if (f == "x") return number(e.position.x);
+                if (f == "y") return number(e.position.y);
+                if (f == "w") return number(e.size.x);
+                if (f == "h") return number(e.size.y);
+                if (f == "toMenu") return boolean(e.goToMenu);
+                return skipValue();
+            });
+        }
+
+        template <typename T>
+        bool append(std::vector<T> &out)
+        {
+            T r;
+            if (!record(r)) return false;
+            out.push_back(r);
+            return true;
+        }
+
+        // Records where an array's contents lie and steps past it without parsing it.
+        // The end is taken to be the first ']', which is right unless a record holds
+        // one; that record is then cut short, and parsing the span fails rather than
+        // giving a wrong result.
+        bool span(Span &out)
+        {
+            if (out.begin || !consume('[')) return false;
+            skipSpace();
+            const void *close = std::memchr(p, ']', end - p);
+            if (!close) return false;
+            out.begin = p;
+            out.end = (const char *)close;
+            p = out.end + 1;
+            return true;
+        }
+
+        void skipSpace()
+        {
+            do
+            {
+                while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+            } while (p == end && refill());
+        }
+
+        bool consume(char c)
+        {
+            skipSpace();
+            if (p == end || *p != c) return false;
+            ++p;
+            return true;
+        }
+
+        bool literal(std::string_view word)
+        {
+            ensure(word.size());
+            if ((size_t)(end - p) < word.size() || std::string_view(p, word.size()) != word) return false;
+            p += word.size();
+            return true;
+        }
+
+        // the raw contents between the quotes, escapes are skipped over but not decoded;
+        // copied out since reading on may move the buffer
+        bool quoted(std::string &out)
+        {
+            if (!consume('"')) return false;
+            for (;;)
+            {
+                size_t i = 0, n = end - p;
+                while (i < n && p[i] != '"') i += p[i] == '\\' ? 2 : 1;
+                if (i < n)
+                {
+                    out.assign(p, i);
+                    p += i + 1;
+                    return true;
+                }
+                if (!refill()) return false;
+            }
+        }
+
+        // numbers are short, 64 bytes hold any the writer produces
+        bool number(float &out)
+        {
+            skipSpace();
+            ensure(64);
+            auto result = std::from_chars(p, end, out);
+            if (result.ec != std::errc()) return false;
+            p = result.ptr;
+            return true;
+        }
+
+        bool integer(size_t &out)
+        {
+            skipSpace();
+            ensure(32);
+            auto result = std::from_chars(p, end, out);
+            if (result.ec != std::errc()) return false;
+            p = result.ptr;
+            return true;
+        }
+
+        bool boolean(bool &out)
+        {
+            skipSpace();
+            if (literal("true")) out = true;
+            else if (literal("false")) out = false;
+            else return false;
+            return true;
+        }
+
+        bool skipValue()
+        {
+            skipSpace();
+            if (p == end) return false;
+            if (*p == '{') return object([&](std::string_view) { return skipValue(); });
+            if (*p == '[') return array([&] { return skipValue(); });
+            if (*p == '"') return quoted(text);
+            if (literal("true") || literal("false") || literal("null")) return true;
+            float f;
+            return number(f);
+        }
+
+        // [ element, ... ], element parses one value
+        template <typename F>
+        bool array(F &&element)
+        {
+            if (!consume('[')) return false;
+            if (consume(']')) return true;
+            do
+            {
+                if (!element()) return false;
+            } while (consume(','));
+            return consume(']');
+        }
+
+        // { "key": value, ... }, field parses the value of each key. The key lives in
+        // text, so it is only good until field reads a string or nested object.
+        template <typename F>
+        bool object(F &&field)
+        {
+            if (!consume('{')) return false;
+            if (consume('}')) return true;
+            do
+            {
+                if (!quoted(text) || !consume(':') || !field(std::string_view(text))) return false;
+            } while (consume(','));
+            return consume('}');
+        }
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <deque>
+#include "simulation.h"
+#include "threadpool.h"
+
+// Saves levels without blocking the caller: save() copies the level and the file is
+// written on the pool, atomically, so an interrupted save leaves the old file intact.
+// poll() hands finished saves back on the caller's thread.
+class LevelSaver
+{
+    public:
+        struct Result
+        {
+            std::string path;
+            bool ok;
+        };
+
+        LevelSaver(ThreadPool &pool) : worker(pool) {}
+
+        void save(const Simulation &level, const std::string &path)
+        {
+            auto snapshot = std::make_shared<Simulation>();
+            snapshot->platforms = level.platforms;
+            snapshot->spikes = level.spikes;
+            snapshot->endPoints = level.endPoints;
+
+            std::shared_ptr<Finished> done = finished;
+            worker.submit([snapshot, path, done](int)
+            {
+                bool ok = snapshot->saveToJson(path);
+                std::lock_guard<std::mutex> lock(done->mutex);
+                done->results.push_back({path, ok});
+            });
+        }
+
+        // Pops the oldest finished save, if any
+        bool poll(Result &result)
+        {
+            std::lock_guard<std::mutex> lock(finished->mutex);
+            if (finished->results.empty()) return false;
+            result = finished->results.front();
+            finished->results.pop_front();
+            return true;
+        }
+
+    private:
+        struct Finished
+        {
+            std::mutex mutex;
+            std::deque<Result> results;
+        };
+
+        ThreadPool &worker;
+        std::shared_ptr<Finished> finished = std::make_shared<Finished>();
+};
@@ -1,21 +1,26 @@
 #include <iostream>
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <fstream>
-#include <regex>
 #include <sstream>
 #include "raylib.h"
 #include "raymath.h"
 #define RAYGUI_IMPLEMENTATION
 #include "raygui.h"
 #include <filesystem>
+#include <ctime>
+#include <chrono>
+#include <cassert>
+#include "simulation.h"
+#include "replay.h"
+#include "prefetch.h"
+#include "levelsaver.h"
+#include "filewatcher.h"
+#include "triplebuffer.h"
 
 const int screenWidth = 1280;
 const int screenHeight = 720;
-const int playerSize = 50;
-const float friction = .9f;
-const float playerSpeed = 100;
-const int gravity = 1300;
-const int jumpForce = 600;
 
 bool blockInput = true;
 bool inMenu = true;
@@ -48,7 +53,8 @@ struct MenuButton {
     void update(Vector2 mousePos, float deltaTime, Sound sound) {
         bool hovering = CheckCollisionPointRec(mousePos, rect);
         float targetOffset = hovering ? 50.0f : 40.0f;
-        hoverOffset = hoverOffset + (targetOffset - hoverOffset) * (10.0f * deltaTime);
+        // a sixth of the way per frame at referenceRate, the same per second at any rate
+        hoverOffset = Lerp(hoverOffset, targetOffset, 1 - powf(1 - 10.0f / referenceRate, deltaTime * referenceRate));
 
         if (hovering && !wasHovering) {PlaySound(sound);}
 
@@ -69,219 +75,381 @@ struct MenuButton {
 };
 
 
-class platform
+void drawPlatform(const platform &p, bool editor)
+{
+    if (p.visible)
+    {
+        DrawRectangleV(p.position, p.size, black);
+    }
+    else if (!p.visible && editor)
+    {
+        DrawRectangleV(p.position, p.size, selected);
+    }
+}
+
+void drawSpike(const Spike &s, bool highlight = false)
+{
+    Vector2 p1 = { s.position.x, s.position.y };
+    Vector2 p2 = { s.position.x + s.size / 2, s.position.y - s.size };
+    Vector2 p3 = { s.position.x + s.size, s.position.y };
+
+    Color fill = highlight ? lightPurple : selected;
+
+    DrawTriangle(p3, p2, p1, fill);
+}
+
+Color endPointColor(const EndPoint &ep)
+{
+    return ep.goToMenu ? (Color){255, 182, 193, 255} : (Color){144, 238, 144, 255};
+}
+
+void drawEndPoint(const EndPoint &ep, bool highlight = false)
+{
+    Color c = endPointColor(ep);
+    if (highlight) c = (Color){255, 255, 0, 255};
+    DrawRectangleV(ep.position, ep.size, c);
+    DrawRectangleLinesEx({ep.position.x, ep.position.y, ep.size.x, ep.size.y}, 2, BLACK);
+}
+
+// position is where to draw the player, which is between steps when interpolating
+void drawPlayer(Vector2 position, bool swinging, Vector2 anchor)
+{
+    if (swinging) {
+        DrawLineV(anchor, position, black);
+        DrawCircleV(anchor, 4, black);
+    }
+
+    Rectangle tempRec = Rectangle{position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize};
+    DrawRectangle(position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize, whiter);
+    DrawRectangleLinesEx(tempRec, 10, black);
+}
+
+// Play-mode level geometry prebuilt into meshes, one per kind of object per chunk of
+// the world, so a frame submits one draw per chunk on screen instead of one per object.
+// Looks the same as drawPlatform, drawSpike and drawEndPoint without highlights.
+class LevelBatch
 {
     public:
-        Vector2 position;
-        Vector2 size;
-        int thickness = 10;
-        bool visible = true;
+        bool dirty = true;
 
-        platform() { position = {0,0}; size = {100,20}; visible = true; }
+        ~LevelBatch() { clear(); }
 
-        platform(float xPos, float yPos, float width, float height, bool vis = true)
+        void build(const Simulation &level)
         {
-            position = {xPos, yPos};
-            size = {width, height};
-            visible = vis;
+            clear();
+            if (!hasMaterial)
+            {
+                material = LoadMaterialDefault();
+                hasMaterial = true;
+            }
+
+            // objects go to the chunk holding their top-left corner
+            std::map<uint64_t, std::vector<int>> byChunk;
+            for (int i = 0; i < (int)level.platforms.size(); ++i)
+                if (level.platforms[i].visible) byChunk[chunkKey(level.platforms[i].position)].push_back(i);
+            buildChunks(byChunk, platformChunks, 6, [&](MeshWriter &w, int i)
+            {
+                w.rect(level.platforms[i].getRect(), black);
+            });
+
+            byChunk.clear();
+            for (int i = 0; i < (int)level.spikes.size(); ++i) byChunk[chunkKey(level.spikes[i].position)].push_back(i);
+            buildChunks(byChunk, spikeChunks, 3, [&](MeshWriter &w, int i)
+            {
+                const Spike &s = level.spikes[i];
+                w.vertex(s.position.x + s.size, s.position.y, selected);
+                w.vertex(s.position.x + s.size / 2, s.position.y - s.size, selected);
+                w.vertex(s.position.x, s.position.y, selected);
+                w.bounds = unionRect(w.bounds, s.getRect());
+            });
+
+            byChunk.clear();
+            for (int i = 0; i < (int)level.endPoints.size(); ++i) byChunk[chunkKey(level.endPoints[i].position)].push_back(i);
+            buildChunks(byChunk, endChunks, 30, [&](MeshWriter &w, int i)
+            {
+                // the fill, then the 2px outline as DrawRectangleLinesEx draws it
+                Rectangle r = level.endPoints[i].getRect();
+                w.rect(r, endPointColor(level.endPoints[i]));
+                w.rect({r.x, r.y, r.width, 2}, BLACK);
+                w.rect({r.x, r.y + r.height - 2, r.width, 2}, BLACK);
+                w.rect({r.x, r.y + 2, 2, r.height - 4}, BLACK);
+                w.rect({r.x + r.width - 2, r.y + 2, 2, r.height - 4}, BLACK);
+            });
+            dirty = false;
         }
 
-        void draw(bool editor)
+        // What draw() draws: platforms and spikes, which TileCache renders ahead, and endpoints
+        enum Layers { Static = 1, EndPoints = 2 };
+
+        // The chunks of layers that view overlaps: platforms, then spikes, then endpoints
+        void draw(Rectangle view, int layers, int &drawn, int &culled) const
         {
-            if (visible)
+            const std::vector<Chunk> *layerChunks[3] = {
+                layers & Static ? &platformChunks : nullptr,
+                layers & Static ? &spikeChunks : nullptr,
+                layers & EndPoints ? &endChunks : nullptr,
+            };
+            for (auto *chunks : layerChunks)
             {
-                DrawRectangleV(position, size, black);
-            }
-            else if (!visible && editor)
-            {
-                DrawRectangleV(position, size, selected);
+                if (!chunks) continue;
+                for (const Chunk &c : *chunks)
+                {
+                    if (!rectsOverlap(c.bounds, view))
+                    {
+                        culled += c.objects;
+                        continue;
+                    }
+                    DrawMesh(c.mesh, material, MatrixIdentity());
+                    drawn += c.objects;
+                }
             }
         }
 
-        Rectangle getRect()
+        // Needs the window still open, the meshes live on the GPU
+        void clear()
         {
-            return Rectangle{position.x, position.y, size.x, size.y};
+            for (auto *chunks : {&platformChunks, &spikeChunks, &endChunks})
+            {
+                for (Chunk &c : *chunks) UnloadMesh(c.mesh);
+                chunks->clear();
+            }
+            dirty = true;
         }
-};
 
-class Spike
-{
-    public:
-        Vector2 position;
-        float size;
+    private:
+        static constexpr float chunkSize = 2048;
 
-        Spike() { position = {0,0}; size = 40; }
-        Spike(float x, float y, float s = 40) { position = {x,y}; size = s; }
+        struct Chunk
+        {
+            Rectangle bounds;
+            Mesh mesh;
+            int objects;
+        };
 
-        void draw(bool highlight = false)
+        struct MeshWriter
         {
-            Vector2 p1 = { position.x, position.y };
-            Vector2 p2 = { position.x + size / 2, position.y - size };
-            Vector2 p3 = { position.x + size, position.y };
+            float *vertices;
+            unsigned char *colors;
+            int count = 0;
+            Rectangle bounds = {0, 0, 0, 0};
 
-            Color fill = highlight ? lightPurple : selected;
+            void vertex(float x, float y, Color c)
+            {
+                vertices[count*3] = x;
+                vertices[count*3 + 1] = y;
+                vertices[count*3 + 2] = 0;
+                colors[count*4] = c.r;
+                colors[count*4 + 1] = c.g;
+                colors[count*4 + 2] = c.b;
+                colors[count*4 + 3] = c.a;
+                ++count;
+            }
 
-            DrawTriangle(p3, p2, p1, fill);
-        }
+            // two triangles wound as raylib's DrawRectangleRec winds them
+            void rect(Rectangle r, Color c)
+            {
+                vertex(r.x, r.y, c);
+                vertex(r.x, r.y + r.height, c);
+                vertex(r.x + r.width, r.y, c);
+                vertex(r.x + r.width, r.y, c);
+                vertex(r.x, r.y + r.height, c);
+                vertex(r.x + r.width, r.y + r.height, c);
+                bounds = unionRect(bounds, r);
+            }
+        };
 
-        Rectangle getRect() const
+        static Rectangle unionRect(Rectangle a, Rectangle b)
         {
-            return Rectangle{ position.x, position.y - size, size, size };
+            if (a.width == 0 && a.height == 0) return b;
+            float left = fminf(a.x, b.x), top = fminf(a.y, b.y);
+            float right = fmaxf(a.x + a.width, b.x + b.width), bottom = fmaxf(a.y + a.height, b.y + b.height);
+            return {left, top, right - left, bottom - top};
         }
-};
-
-class EndPoint {
-    public:
-        Vector2 position;
-        Vector2 size;
-        bool goToMenu;
 
-        EndPoint(float x = 0, float y = 0, float w = 60, float h = 60, bool toMenu = false)
-            : position({x, y}), size({w, h}), goToMenu(toMenu) {}
-
-        void draw(bool highlight = false) {
-            Color c = goToMenu ? (Color){255, 182, 193, 255} : (Color){144, 238, 144, 255};
-            if (highlight) c = (Color){255, 255, 0, 255};
-            DrawRectangleV(position, size, c);
-            DrawRectangleLinesEx({position.x, position.y, size.x, size.y}, 2, BLACK);
+        static uint64_t chunkKey(Vector2 p)
+        {
+            uint32_t cx = (uint32_t)(int32_t)floorf(p.x / chunkSize);
+            uint32_t cy = (uint32_t)(int32_t)floorf(p.y / chunkSize);
+            return (uint64_t)cx << 32 | cy;
         }
 
-        Rectangle getRect() const {
-            return {position.x, position.y, size.x, size.y};
+        // Writes each chunk's objects into one mesh and uploads it. Only the GPU copy
+        // is kept.
+        template <typename F>
+        void buildChunks(const std::map<uint64_t, std::vector<int>> &byChunk, std::vector<Chunk> &out,
+                         int verticesPerObject, F &&write)
+        {
+            for (auto &entry : byChunk)
+            {
+                int capacity = (int)entry.second.size() * verticesPerObject;
+                Mesh mesh = {0};
+                MeshWriter w;
+                w.vertices = (float *)MemAlloc(capacity * 3 * sizeof(float));
+                w.colors = (unsigned char *)MemAlloc(capacity * 4);
+                for (int i : entry.second) write(w, i);
+
+                mesh.vertexCount = w.count;
+                mesh.triangleCount = w.count / 3;
+                mesh.vertices = w.vertices;
+                mesh.colors = w.colors;
+                UploadMesh(&mesh, false);
+                MemFree(mesh.vertices);
+                MemFree(mesh.colors);
+                mesh.vertices = nullptr;
+                mesh.colors = nullptr;
+                out.push_back({w.bounds, mesh, (int)entry.second.size()});
+            }
         }
-};
 
+        std::vector<Chunk> platformChunks;
+        std::vector<Chunk> spikeChunks;
+        std::vector<Chunk> endChunks;
+        Material material;
+        bool hasMaterial = false;
+};
 
-class Player
+// The static part of the level, platforms and spikes, rendered from LevelBatch into
+// textures one tile of the world at a time. Tiles are rendered when first on screen and
+// kept while they fit the budget, the least recently drawn going first, so play mode
+// draws a few textured quads per frame however dense the level is. Play mode's camera
+// never zooms, so a tile is one texel per world unit.
+class TileCache
 {
     public:
-        Vector2 position;
-        int direction = 0;
-        float xVelocity = 0;
-        float yVelocity = 0;
-        float thickness = 10;
-        bool canJump = true;
+        static constexpr int tileSize = 512;
+        size_t budget = (size_t)96 << 20; // bytes of tile textures kept
+        int drawnTiles = 0;
 
-        bool swinging = false;
-        Vector2 anchor;
-        float ropeLength;
-        float ropeAngle;
-        float angularVelocity;
+        ~TileCache() { clear(); }
 
-        bool wasSwingingLastFrame = false;
+        // Renders the tiles view needs that are missing or stale. Switches render target,
+        // so it runs before BeginDrawing. hasContent skips tiles with nothing to draw.
+        template <typename F>
+        void prepare(Rectangle view, const LevelBatch &batch, F &&hasContent)
+        {
+            ++frame;
+            forTiles(view, [&](int tx, int ty)
+            {
+                Tile &t = tiles[key(tx, ty)];
+                t.lastUsed = frame;
+                if (!t.stale) return;
+                t.stale = false;
 
-        void draw()
-        {   
-            if (swinging) {
-                DrawLineV(anchor, position, black);
-                DrawCircleV(anchor, 4, black);
-            }
+                Rectangle area = tileRect(tx, ty);
+                if (!hasContent(area))
+                {
+                    // empty tiles are remembered without a texture
+                    release(t);
+                    return;
+                }
+                if (t.texture.id == 0)
+                {
+                    t.texture = LoadRenderTexture(tileSize, tileSize);
+                    resident += tileBytes;
+                }
 
-            Rectangle tempRec = Rectangle{position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize};
-            DrawRectangle(position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize, whiter);
-            DrawRectangleLinesEx(tempRec, 10, black);
+                Camera2D tileCamera = {0};
+                tileCamera.target = {area.x, area.y};
+                tileCamera.zoom = 1;
+                int drawn = 0, culled = 0;
+                BeginTextureMode(t.texture);
+                ClearBackground(BLANK);
+                BeginMode2D(tileCamera);
+                batch.draw(area, LevelBatch::Static, drawn, culled);
+                EndMode2D();
+                EndTextureMode();
+            });
+            evict();
         }
 
-        void update(vector<platform>& platforms, vector<Spike>& spikes)
+        void draw(Rectangle view)
         {
-            float deltaTime = GetFrameTime();
+            drawnTiles = 0;
+            forTiles(view, [&](int tx, int ty)
+            {
+                auto it = tiles.find(key(tx, ty));
+                if (it == tiles.end() || it->second.texture.id == 0) return;
+                // render textures are stored bottom up
+                Rectangle source = {0, 0, (float)tileSize, -(float)tileSize};
+                DrawTexturePro(it->second.texture.texture, source, tileRect(tx, ty), {0, 0}, 0, WHITE);
+                ++drawnTiles;
+            });
+        }
 
-            if (swinging) {
-                float g = 1300.0f;
-                float angularAccel = -(g / ropeLength) * sinf(ropeAngle - PI/2);
+        // For an edit inside area: the tiles it touches are rendered again when next seen
+        void invalidate(Rectangle area)
+        {
+            forTiles(area, [&](int tx, int ty)
+            {
+                auto it = tiles.find(key(tx, ty));
+                if (it != tiles.end()) it->second.stale = true;
+            });
+        }
 
-                if (IsKeyDown(KEY_D)) angularAccel -= 2.0f;
-                if (IsKeyDown(KEY_A)) angularAccel += 2.0f;
+        // Needs the window still open, like LevelBatch::clear
+        void clear()
+        {
+            for (auto &entry : tiles) release(entry.second);
+            tiles.clear();
+        }
 
-                angularVelocity += angularAccel * deltaTime;
-                angularVelocity *= 0.995f;
-                ropeAngle += angularVelocity * deltaTime;
+        int residentTiles() const { return (int)(resident / tileBytes); }
 
-                position.x = anchor.x + ropeLength * cosf(ropeAngle);
-                position.y = anchor.y + ropeLength * sinf(ropeAngle);
-            } else {
-                xVelocity = (xVelocity + direction) * friction;
-                position.x += xVelocity * deltaTime * playerSpeed;
-                yVelocity += gravity * deltaTime;
-                position.y += yVelocity * deltaTime;
-            }
+    private:
+        static constexpr size_t tileBytes = (size_t)tileSize * tileSize * 4;
 
+        struct Tile
+        {
+            RenderTexture2D texture = {0};
+            bool stale = true;
+            uint64_t lastUsed = 0;
+        };
 
-            canJump = false;
+        std::unordered_map<uint64_t, Tile> tiles;
+        uint64_t frame = 0;
+        size_t resident = 0;
 
-            for (auto& plat : platforms)
-            {
-                Rectangle platRect = plat.getRect();
-                Rectangle playerRect = {position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize};
-                if (CheckCollisionRecs(playerRect, platRect))
-                {
-                    float overlapLeft   = (playerRect.x + playerRect.width) - platRect.x;
-                    float overlapRight  = (platRect.x + platRect.width) - playerRect.x;
-                    float overlapTop    = (playerRect.y + playerRect.height) - platRect.y;
-                    float overlapBottom = (platRect.y + platRect.height) - playerRect.y;
-                    float minOverlapX = (overlapLeft < overlapRight) ? overlapLeft : -overlapRight;
-                    float minOverlapY = (overlapTop < overlapBottom) ? overlapTop : -overlapBottom;
-
-                    if (!swinging)
-                    {
-                        if (abs(minOverlapX) < abs(minOverlapY))
-                        {
-                            position.x -= minOverlapX;
-                            xVelocity = 0;
-                        }
-                        else
-                        {
-                            position.y -= minOverlapY;
-                            yVelocity = 0;
-                            if (minOverlapY > 0)
-                            {
-                                canJump = true;
-                            }
-                        }
-                    }
-                    else
-                    {
-                        if (fabs(angularVelocity) < 1.0f)
-                            {
-                                angularVelocity = 0;
-                                swinging = false;
-                                xVelocity = 0;
-                                yVelocity = 0;
-
-                                if (abs(minOverlapX) < abs(minOverlapY))
-                                    position.x -= minOverlapX;
-                                else
-                                    position.y -= minOverlapY;
-                            }
-                        else
-                        {
-                            angularVelocity = -angularVelocity * .95f;
-                        }
-                    }
-                }
-            }
+        static uint64_t key(int tx, int ty)
+        {
+            return (uint64_t)(uint32_t)tx << 32 | (uint32_t)ty;
+        }
 
-            for (auto& s : spikes)
-            {
-                Rectangle spikeRect = s.getRect();
-                Rectangle playerRect = {position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize};
-                if (CheckCollisionRecs(playerRect, spikeRect))
-                {
-                    position = {screenWidth / 2, screenHeight /2};
-                    xVelocity = 0;
-                    yVelocity = 0;
-                    swinging = false;
-                }
-            }
-            
-            wasSwingingLastFrame = swinging;
+        static Rectangle tileRect(int tx, int ty)
+        {
+            return {(float)tx * tileSize, (float)ty * tileSize, (float)tileSize, (float)tileSize};
+        }
+
+        template <typename F>
+        static void forTiles(Rectangle area, F &&f)
+        {
+            int x0 = (int)floorf(area.x / tileSize), x1 = (int)floorf((area.x + area.width) / tileSize);
+            int y0 = (int)floorf(area.y / tileSize), y1 = (int)floorf((area.y + area.height) / tileSize);
+            for (int ty = y0; ty <= y1; ++ty)
+                for (int tx = x0; tx <= x1; ++tx) f(tx, ty);
+        }
+
+        void release(Tile &t)
+        {
+            if (t.texture.id == 0) return;
+            UnloadRenderTexture(t.texture);
+            t.texture = {0};
+            resident -= tileBytes;
         }
-        void jump()
+
+        // Drops least recently drawn tiles until the rest fit the budget. Tiles on screen
+        // this frame stay even over it. The budget holds a few hundred tiles at most, so
+        // a scan for the oldest is cheap next to rendering one.
+        void evict()
         {
-            if (canJump)
+            while (resident > budget)
             {
-                yVelocity = -jumpForce;
-                canJump = false;
+                auto oldest = tiles.end();
+                for (auto it = tiles.begin(); it != tiles.end(); ++it)
+                    if (it->second.texture.id != 0 && (oldest == tiles.end() || it->second.lastUsed < oldest->second.lastUsed))
+                        oldest = it;
+                if (oldest == tiles.end() || oldest->second.lastUsed == frame) break;
+                release(oldest->second);
+                tiles.erase(oldest);
             }
         }
 };
@@ -296,12 +464,10 @@ struct ResizeMask
     bool any() const { return left||right||top||bottom; }
 };
 
-class Game
+// raylib front-end around the headless simulation: camera, editor, sounds and level flow
+class Game : public Simulation
 {
     public:
-        Player player = Player();
-        vector<platform> platforms;
-        vector<Spike> spikes;
         Camera2D camera = {0};
 
         bool editMode = false;
@@ -321,7 +487,6 @@ class Game
         int selectedSpikeIndex = -1;
         Vector2 spikeDragOffset = {0, 0};
 
-        std::vector<EndPoint> endPoints;
         int selectedEndIndex = -1;
         bool draggingEnd = false;
         Vector2 endDragOffset = {0, 0};
@@ -334,10 +499,116 @@ class Game
         string currentLevelName = "tutorial";
 
         Sound endSound;
+        Sound launchSound;
+        Sound releaseSound;
+        Sound resetSound;
+
+        int simulationRate = 120;
+        int maxStepsPerFrame = 8;
+        float accumulator = 0;
+        // The player and camera as drawn. The simulation only moves them in whole steps,
+        // so frames show them blended from where the last step found them to where it
+        // left them, by how far the frame has got into the next step: smooth at any
+        // frame rate, one step behind the simulation. previousPosition and previousTarget
+        // are for replays, live play's come with each View.
+        Vector2 previousPosition = spawnPoint;
+        Vector2 previousTarget = {0, 0};
+        Vector2 shownPosition = spawnPoint;
+        Camera2D shownCamera = {0};
+        bool shownSwinging = false;
+        Vector2 shownAnchor = {0, 0};
+
+        // --- Simulation thread ---
+        // Live play steps on a thread of its own at simulationRate, whatever the frame
+        // rate, and publishes each step's View for the frames to draw. While it runs it
+        // owns the player, the camera's target, pendingInput and the recorder; the level
+        // is only read, by both threads. Anything else that changes them parks it first:
+        // the menu, the editor, loads and reloads, and reaching an endpoint, where it parks
+        // itself until the main thread has changed level.
+        struct View
+        {
+            Vector2 previousPosition;
+            Vector2 position;
+            Vector2 previousTarget;
+            Vector2 target;
+            bool swinging;
+            Vector2 anchor;
+            // when position became current, a frame blends toward it from there
+            std::chrono::steady_clock::time_point stepTime;
+            // running counts, each rise is a sound for the main thread to play
+            unsigned hooks;
+            unsigned releases;
+            unsigned resets;
+        };
+
+        TripleBuffer<View> views;
+        unsigned hooks = 0, releases = 0, resets = 0;
+        unsigned heardHooks = 0, heardReleases = 0, heardResets = 0;
+
+        std::mutex simMutex;
+        std::condition_variable simWake;
+        std::condition_variable simIdle;
+        // guarded by simMutex
+        bool simRun = false;
+        bool simBusy = false;
+        bool simQuit = false;
+        int reachedEnd = -1;
+        InputState sharedInput;
+        std::chrono::steady_clock::time_point simStart;
+        std::thread simThread;
+
+        Game()
+        {
+            parsePool = &levelParse;
+            simThread = std::thread([this] { simulationLoop(); });
+        }
+
+        ~Game()
+        {
+            {
+                std::lock_guard<std::mutex> lock(simMutex);
+                simQuit = true;
+            }
+            simWake.notify_all();
+            simThread.join();
+        }
+        InputState pendingInput;
+
+        // every level played from its file is recorded, one replay per session
+        ReplayRecorder recorder;
+        string levelPath;
+        bool segmentPending = false;
+        ReplayCursor playback;
+
+        // large level files are parsed over the cores the game's own threads leave free
+        ThreadPool levelParse{(int)std::thread::hardware_concurrency() - 1};
+        // level files are read and written on one background thread, in order, so a
+        // prefetch never sees a save half done
+        ThreadPool levelIo{1};
+        // the next campaign level, loaded in the background while this one is played
+        LevelPrefetcher prefetcher{levelIo, &levelParse};
+        // the campaign level the player reached the end for while its prefetch was still
+        // loading; frames go on with play paused until it is ready
+        string arrivingLevel;
+        LevelSaver saver{levelIo};
+        // level files changed by other programs, and the current one being read back in
+        FileWatcher levelWatcher;
+        LevelPrefetcher reloader{levelIo, &levelParse};
+
+        // Play mode draws the level from batches, culled by chunk. The editor draws
+        // objects one by one, only those its grids place on screen: collision's, per
+        // object and kept in step with its edits while it is open, and endCells.
+        LevelBatch batch;
+        TileCache tiles;
+        SpatialGrid endCells;
+        vector<int> onScreen;
+        vector<int> picked;
+        int drawnObjects = 0;
+        int culledObjects = 0;
 
         void gameStart()
         {
-            player.position = {screenWidth / 2, screenHeight /2};
+            player.position = spawnPoint;
             platforms.push_back(platform(300, 500, 400, 40, true));
             platforms.push_back(platform(800, 400, 200, 40, true));
             platforms.push_back(platform(100, 300, 250, 40, true));
@@ -347,14 +618,18 @@ class Game
             camera.target = player.position;
 
             spikes.push_back(Spike(600, 500));
+            compileCollision();
+            levelChanged();
         }
 
+        // the editor's collision index is per object, so its grid finds the candidates
         int pickPlatformAtPoint(Vector2 worldPoint)
         {
-            for (int i = (int)platforms.size()-1; i >= 0; --i)
+            collision.platforms.query({worldPoint.x, worldPoint.y, 0, 0}, picked);
+            for (int k = (int)picked.size()-1; k >= 0; --k)
             {
-                Rectangle r = platforms[i].getRect();
-                if (CheckCollisionPointRec(worldPoint, r)) return i;
+                Rectangle r = platforms[picked[k]].getRect();
+                if (CheckCollisionPointRec(worldPoint, r)) return picked[k];
             }
             return -1;
         }
@@ -404,6 +679,7 @@ class Game
         {
             if (selectedIndex < 0) return;
             platform &p = platforms[selectedIndex];
+            Rectangle before = p.getRect();
             if (currentAction == MOVE)
             {
                 p.position = { worldPoint.x - dragOffset.x, worldPoint.y - dragOffset.y };
@@ -447,6 +723,9 @@ class Game
                 p.position = np;
                 p.size = ns;
             }
+            collision.movePlatform(selectedIndex, before, p);
+            edited(before);
+            edited(p.getRect());
         }
 
         void endDrag()
@@ -455,77 +734,206 @@ class Game
             resizeMask = ResizeMask();
         }
 
-        void update()
+        // the camera closes a tenth of its distance to the player per step at referenceRate
+        float followFactor(float deltaTime)
+        {
+            return 1 - powf(1 - 0.1f, deltaTime * referenceRate);
+        }
+
+        // Advances live play by one fixed step, on the simulation thread
+        StepEvents stepLive(float deltaTime)
+        {
+            if (segmentPending)
+            {
+                recorder.begin(levelPath, player, simulationRate, deterministic, bakeGeometry);
+                segmentPending = false;
+            }
+            recorder.record(pendingInput);
+
+            StepEvents events = step(pendingInput, deltaTime);
+            recorder.stepped(player);
+            pendingInput.hook = false;
+            pendingInput.release = false;
+
+            // counted for the main thread, which plays the sounds
+            if (events.hooked) hooks++;
+            if (events.released && abs(events.releaseSpeed) > 1) releases++;
+            if (events.fellOut || pendingInput.reset) resets++;
+            float lerpFactor = followFactor(deltaTime);
+            camera.target.x = Lerp(camera.target.x, player.position.x, lerpFactor);
+            camera.target.y = Lerp(camera.target.y, player.position.y, lerpFactor);
+            return events;
+        }
+
+        // --- Endpoint reached (level transitions) ---
+        // On the main thread, with the simulation thread parked
+        void leaveLevel(int endPoint)
+        {
+            if (endPoint < 0 || endPoint >= (int)endPoints.size()) return;
+            EndPoint &ep = endPoints[endPoint];
+            PlaySound(endSound);
+
+            if (ep.goToMenu)
+            {
+                inMenu = true;
+                blockInput = true;
+                allowEditor = false;
+                player.respawn();
+            }
+            else
+            {
+                auto it = std::find(levelOrder.begin(), levelOrder.end(), currentLevelName);
+                if (it != levelOrder.end())
+                {
+                    ++it;
+                    if (it != levelOrder.end())
+                    {
+                        string next = "levels/" + *it + ".json";
+                        if (prefetcher.holds(next) && !prefetcher.ready(next)) arrivingLevel = *it;
+                        else enterLevel(*it);
+                    }
+                    else
+                    {
+                        inMenu = true;
+                        allowEditor = false;
+                        blockInput = true;
+                        player.respawn();
+                    }
+                }
+                else
+                {
+                    inMenu = true;
+                    allowEditor = false;
+                    blockInput = true;
+                    player.respawn();
+                }
+            }
+        }
+
+        // Moves on to the campaign level name
+        void enterLevel(const string &name)
+        {
+            currentLevelName = name;
+            loadFromJson("levels/" + name + ".json");
+            player.respawn();
+        }
+
+        void playStepSounds(const StepEvents &events)
+        {
+            if (events.hooked) PlaySound(launchSound);
+            if (events.released && abs(events.releaseSpeed) > 1) PlaySound(releaseSound);
+            if (events.fellOut || pendingInput.reset) PlaySound(resetSound);
+        }
+
+        // steps the replay instead of the player's input, levels follow the recording
+        bool advancePlayback(float deltaTime, float lerpFactor)
+        {
+            if (playback.atSegmentStart())
+            {
+                const ReplaySegment &seg = playback.currentSegment();
+                Simulation::loadFromJson(seg.level);
+                levelChanged();
+                player = seg.start;
+                camera.target = player.position;
+                snapView();
+            }
+
+            const ReplaySegment &seg = playback.currentSegment();
+            pendingInput = playback.next();
+            StepEvents events = step(pendingInput, deltaTime);
+            playStepSounds(events);
+
+            camera.target.x = Lerp(camera.target.x, player.position.x, lerpFactor);
+            camera.target.y = Lerp(camera.target.y, player.position.y, lerpFactor);
+
+            if (!playback.done() && !playback.atSegmentStart()) return false;
+
+            bool match = playerStateHash(player) == seg.endHash;
+            TraceLog(match ? LOG_INFO : LOG_WARNING, "REPLAY: %s %s the recording", seg.level.c_str(), match ? "matches" : "diverged from");
+            if (!playback.done()) return true;
+
+            playback = ReplayCursor();
+            pendingInput = InputState();
+            inMenu = true;
+            blockInput = true;
+            player.respawn();
+            return true;
+        }
+
+        // starts real-time playback of a replay, which must outlive it. The simulation
+        // thread must be parked: it owns the recorder and player while it runs.
+        void startPlayback(const Replay &replay)
+        {
+            assert(!simulating());
+            playback.reset(replay);
+            if (playback.done()) return;
+            deterministic = replay.deterministic;
+            bakeGeometry = replay.bakedGeometry;
+            recorder.end();
+            segmentPending = false;
+            inMenu = false;
+            blockInput = true;
+            allowEditor = false;
+            setEditMode(false);
+        }
+
+        // writes out the session's replay, if anything was played. The simulation thread
+        // must be parked, it records while it steps.
+        void finishRecording()
         {
-            float lerpFactor = 0.1f;
+            assert(!simulating());
+            recorder.end();
+            segmentPending = false;
+            if (recorder.replay.totalSteps() == 0)
+            {
+                recorder.replay.segments.clear();
+                return;
+            }
+
+            fs::create_directories("replays");
+            string path = "replays/session-" + to_string((long long)time(nullptr)) + ".replay";
+            if (recorder.replay.save(path))
+                TraceLog(LOG_INFO, "REPLAY: saved %s (%llu steps, final state %016llx)", path.c_str(),
+                         (unsigned long long)recorder.replay.totalSteps(), (unsigned long long)recorder.replay.segments.back().endHash);
+            recorder.replay.segments.clear();
+        }
 
+        void update(const InputState &input)
+        {
             // --- PLAY MODE ---
             if (!editMode)
             {
-                player.update(platforms, spikes);
-                camera.target.x = Lerp(camera.target.x, player.position.x, lerpFactor);
-                camera.target.y = Lerp(camera.target.y, player.position.y, lerpFactor);
-
-                // --- Endpoint collision detection (level transitions) ---
-                Rectangle playerRect = {
-                    player.position.x - playerSize / 2,
-                    player.position.y - playerSize / 2,
-                    playerSize, playerSize
-                };
-
-                for (auto &ep : endPoints)
+                if (!playback.replay)
                 {
-                    if (CheckCollisionRecs(playerRect, ep.getRect()))
+                    submitInput(input);
+                    return;
+                }
+
+                // replays step here, their segments load levels
+                float fixedStep = 1.0f / simulationRate;
+                accumulator += GetFrameTime();
+
+                int steps = 0;
+                while (accumulator >= fixedStep)
+                {
+                    // drop the backlog after a long hitch instead of spiralling
+                    if (steps == maxStepsPerFrame)
                     {
-                        PlaySound(endSound);
+                        accumulator = 0;
+                        break;
+                    }
 
-                        if (ep.goToMenu)
-                        {
-                            inMenu = true;
-                            blockInput = true;
-                            allowEditor = false;
-                            player.position = {screenWidth / 2, screenHeight /2};
-                            player.xVelocity = 0;
-                            player.yVelocity = 0;
-                            player.swinging = false;
-                        }
-                        else
-                        {
-                            auto it = std::find(levelOrder.begin(), levelOrder.end(), currentLevelName);
-                            if (it != levelOrder.end())
-                            {
-                                ++it;
-                                if (it != levelOrder.end())
-                                {
-                                    currentLevelName = *it;
-                                    loadFromJson("levels/" + currentLevelName + ".json");
-                                    player.position = {screenWidth / 2, screenHeight /2};
-                                    player.xVelocity = 0;
-                                    player.yVelocity = 0;
-                                    player.swinging = false;
-                                }
-                                else
-                                {
-                                    inMenu = true;
-                                    allowEditor = false;
-                                    blockInput = true;
-                                    player.position = {screenWidth / 2, screenHeight /2};
-                                    player.xVelocity = 0;
-                                    player.yVelocity = 0;
-                                    player.swinging = false;
-                                }
-                            }
-                            else
-                            {
-                                inMenu = true;
-                                allowEditor = false;
-                                blockInput = true;
-                                player.position = {screenWidth / 2, screenHeight /2};
-                                player.xVelocity = 0;
-                                player.yVelocity = 0;
-                                player.swinging = false;
-                            }
-                        }
+                    accumulator -= fixedStep;
+                    steps++;
+
+                    previousPosition = player.position;
+                    previousTarget = camera.target;
+                    bool left = advancePlayback(fixedStep, followFactor(fixedStep));
+                    // a respawn is a jump to draw at once
+                    if (player.respawned) snapView();
+                    if (left)
+                    {
+                        accumulator = 0;
                         break;
                     }
                 }
@@ -636,7 +1044,11 @@ class Game
             {
                 if (draggingSpike && selectedSpikeIndex != -1)
                 {
+                    Rectangle before = spikes[selectedSpikeIndex].getRect();
                     spikes[selectedSpikeIndex].position = Vector2Add(mouseWorld, spikeDragOffset);
+                    collision.moveSpike(selectedSpikeIndex, before, spikes[selectedSpikeIndex]);
+                    edited(before);
+                    edited(spikes[selectedSpikeIndex].getRect());
                 }
                 else if (currentAction != NONE)
                 {
@@ -645,6 +1057,7 @@ class Game
                 else if (draggingEnd && selectedEndIndex != -1)
                 {
                     endPoints[selectedEndIndex].position = Vector2Add(mouseWorld, endDragOffset);
+                    placeEndPoint(selectedEndIndex);
                 }
             }
 
@@ -656,6 +1069,7 @@ class Game
                     // --- SNAP TO PLATFORM TOP ---
                     float snapThreshold = 20.0f;
                     Spike &s = spikes[selectedSpikeIndex];
+                    Rectangle before = s.getRect();
 
                     for (auto &p : platforms)
                     {
@@ -675,6 +1089,9 @@ class Game
                             break;
                         }
                     }
+                    collision.moveSpike(selectedSpikeIndex, before, s);
+                    edited(before);
+                    edited(s.getRect());
 
                     draggingSpike = false;
                     selectedSpikeIndex = -1;
@@ -697,12 +1114,16 @@ class Game
                 Vector2 pos = {mouseWorld.x - size.x / 2.0f, mouseWorld.y - size.y / 2.0f};
                 platforms.emplace_back(pos.x, pos.y, size.x, size.y);
                 selectedIndex = (int)platforms.size() - 1;
+                collision.addPlatform(platforms.back());
+                edited(platforms.back().getRect());
             }
 
             if (IsKeyPressed(KEY_Q))
             {
                 Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), camera);
                 spikes.emplace_back(mouseWorld.x - 20, mouseWorld.y + 20);
+                collision.addSpike(spikes.back());
+                edited(spikes.back().getRect());
             }
 
             if (IsKeyPressed(KEY_T))
@@ -716,6 +1137,7 @@ class Game
                 {
                     endPoints[0].position = { mouseWorld.x - 30, mouseWorld.y - 30 };
                 }
+                placeEndPoint(0);
             }
 
             if (IsKeyPressed(KEY_Y))
@@ -723,6 +1145,7 @@ class Game
                 if (selectedEndIndex >= 0 && selectedEndIndex < (int)endPoints.size())
                 {
                     endPoints[selectedEndIndex].goToMenu = !endPoints[selectedEndIndex].goToMenu;
+                    batch.dirty = true;
                 }
             }
 
@@ -734,12 +1157,14 @@ class Game
         }
 
 
-        void drawEditorUI()
+        void drawEditorUI(Rectangle view)
         {
             Vector2 mouseScreen = GetMousePosition();
             Vector2 mouseWorld = GetScreenToWorld2D(mouseScreen, camera);
             int hoverIndex = pickPlatformAtPoint(mouseWorld);
-            for (int i = 0; i < (int)platforms.size(); ++i)
+            collision.platforms.query(view, onScreen);
+            countDrawn((int)onScreen.size(), (int)platforms.size());
+            for (int i : onScreen)
             {
                 platform &p = platforms[i];
                 Rectangle r = p.getRect();
@@ -757,6 +1182,7 @@ class Game
                     if(IsKeyPressed(KEY_V))
                     {
                         p.visible = !p.visible;
+                        edited(r);
                     }
                 }
                 else if (i == hoverIndex)
@@ -766,7 +1192,7 @@ class Game
                 }
                 else
                 {
-                    p.draw(editMode);
+                    drawPlatform(p, editMode);
                 }
             }
             if (hoverIndex >= 0)
@@ -783,158 +1209,417 @@ class Game
 
         void draw()
         {
+            drawnObjects = culledObjects = 0;
+            // a margin for the outlines and the editor's corner handles
+            Rectangle view = cameraView(8);
+
             if (!editMode)
             {
-                player.draw();
-                for (auto& plat : platforms) plat.draw(editMode);
+                if (batch.dirty) batch.build(*this);
+                tiles.draw(view);
+                batch.draw(view, LevelBatch::EndPoints, drawnObjects, culledObjects);
+                // meshes are submitted as they are drawn and the rest is batched by
+                // raylib, so the player always ends up over the level
+                drawPlayer(shownPosition, shownSwinging, shownAnchor);
+                return;
             }
-            else
+
+            /*for (int i = 0; i < (int)platforms.size(); ++i)
             {
-                /*for (int i = 0; i < (int)platforms.size(); ++i)
+                platform &p = platforms[i];
+                Rectangle r = p.getRect();
+                if (i == selectedIndex)
                 {
-                    platform &p = platforms[i];
-                    Rectangle r = p.getRect();
-                    if (i == selectedIndex)
-                    {
-                        //DrawRectangleV(p.position, p.size, (Color){230,230,255,255});
-                        //DrawRectangleLinesEx(r, 3, (Color){255,140,0,255});
-                    }
-                    else
-                    {
-                        //DrawRectangleV(p.position, p.size, (Color){200,200,200,255});
-                        //DrawRectangleLinesEx(r, 1, black);
-                    }
-                }*/
-                drawEditorUI();
-            }
+                    //DrawRectangleV(p.position, p.size, (Color){230,230,255,255});
+                    //DrawRectangleLinesEx(r, 3, (Color){255,140,0,255});
+                }
+                else
+                {
+                    //DrawRectangleV(p.position, p.size, (Color){200,200,200,255});
+                    //DrawRectangleLinesEx(r, 1, black);
+                }
+            }*/
+            drawEditorUI(view);
 
-            for (int i = 0; i < (int)spikes.size(); i++)
+            collision.spikes.query(view, onScreen);
+            countDrawn((int)onScreen.size(), (int)spikes.size());
+            for (int i : onScreen)
             {
                 bool highlight = (i == selectedSpikeIndex);
-                spikes[i].draw(highlight);
+                drawSpike(spikes[i], highlight);
             }
 
-            for (int i = 0; i < (int)endPoints.size(); i++) {
+            endCells.query(view, onScreen);
+            countDrawn((int)onScreen.size(), (int)endPoints.size());
+            for (int i : onScreen) {
                 bool highlight = (i == selectedEndIndex);
-                endPoints[i].draw(highlight);
+                drawEndPoint(endPoints[i], highlight);
             }
         }
 
-        void reset(Sound resetSound)
+        // The world-space rectangle the drawn camera shows, grown by margin on every side
+        Rectangle cameraView(float margin)
         {
-            PlaySound(resetSound);
-            player.position = {screenWidth / 2, screenHeight /2};
-            player.xVelocity = 0;
-            player.yVelocity = 0;
-            player.swinging = false;
+            Vector2 a = GetScreenToWorld2D({0, 0}, shownCamera);
+            Vector2 b = GetScreenToWorld2D({(float)GetScreenWidth(), 0}, shownCamera);
+            Vector2 c = GetScreenToWorld2D({0, (float)GetScreenHeight()}, shownCamera);
+            Vector2 d = GetScreenToWorld2D({(float)GetScreenWidth(), (float)GetScreenHeight()}, shownCamera);
+            float left = fminf(fminf(a.x, b.x), fminf(c.x, d.x)) - margin;
+            float top = fminf(fminf(a.y, b.y), fminf(c.y, d.y)) - margin;
+            float right = fmaxf(fmaxf(a.x, b.x), fmaxf(c.x, d.x)) + margin;
+            float bottom = fmaxf(fmaxf(a.y, b.y), fmaxf(c.y, d.y)) + margin;
+            return {left, top, right - left, bottom - top};
         }
 
-        bool saveToJson(const string &path)
+        // Grid candidates share a cell with the view, a few just off screen are drawn too
+        void countDrawn(int drawn, int total)
         {
-            namespace fs = filesystem;
-            fs::create_directories("levels");
-
-            ofstream out(path);
-            if (!out.is_open()) return false;
+            drawnObjects += drawn;
+            culledObjects += total - drawn;
+        }
 
-            out << "{\n";
-            out << "  \"platforms\": [\n";
-            for (size_t i = 0; i < platforms.size(); ++i)
+        // Sets what is drawn for the player and camera this frame, see previousPosition.
+        // The editor moves the camera itself and draws it as it is.
+        void updateView()
+        {
+            if (simulating())
             {
-                platform &p = platforms[i];
-                out << "    {\"x\":" << p.position.x
-                    << ",\"y\":" << p.position.y
-                    << ",\"w\":" << p.size.x 
-                    << ",\"h\":" << p.size.y 
-                    << ",\"visible\":" << (p.visible ? "true" : "false") << "}";
-                if (i + 1 < platforms.size()) out << ",";
-                out << "\n";
+                views.update();
+                const View &v = views.front();
+                float sinceStep = std::chrono::duration<float>(std::chrono::steady_clock::now() - v.stepTime).count();
+                float alpha = Clamp(sinceStep * simulationRate, 0, 1);
+                shownPosition = Vector2Lerp(v.previousPosition, v.position, alpha);
+                // the simulation thread writes camera.target, the rest is the main thread's
+                shownCamera.offset = camera.offset;
+                shownCamera.rotation = camera.rotation;
+                shownCamera.zoom = camera.zoom;
+                shownCamera.target = Vector2Lerp(v.previousTarget, v.target, alpha);
+                shownSwinging = v.swinging;
+                shownAnchor = v.anchor;
+
+                if (v.hooks != heardHooks) PlaySound(launchSound);
+                if (v.releases != heardReleases) PlaySound(releaseSound);
+                if (v.resets != heardResets) PlaySound(resetSound);
+                heardHooks = v.hooks;
+                heardReleases = v.releases;
+                heardResets = v.resets;
+                return;
             }
-            out << "  ],\n";
 
-            out << "  \"spikes\": [\n";
-            for (size_t i = 0; i < spikes.size(); ++i)
+            shownCamera = camera;
+            shownPosition = player.position;
+            shownSwinging = player.swinging;
+            shownAnchor = player.anchor;
+            // replays step on this thread and blend like the simulation thread's steps
+            if (editMode || !playback.replay) return;
+
+            float alpha = Clamp(accumulator * simulationRate, 0, 1);
+            shownPosition = Vector2Lerp(previousPosition, player.position, alpha);
+            shownCamera.target = Vector2Lerp(previousTarget, camera.target, alpha);
+        }
+
+        // True while the simulation thread may be stepping, main thread only
+        bool simulating()
+        {
+            std::lock_guard<std::mutex> lock(simMutex);
+            return simRun;
+        }
+
+        // Once a frame: hands an endpoint the simulation reached to leaveLevel, then has
+        // the thread running exactly while live play is on
+        void runSimulation()
+        {
+            int end;
             {
-                Spike &s = spikes[i];
-                out << "    {\"x\":" << s.position.x << ",\"y\":" << s.position.y
-                    << ",\"size\":" << s.size << "}";
-                if (i + 1 < spikes.size()) out << ",";
-                out << "\n";
+                std::lock_guard<std::mutex> lock(simMutex);
+                end = reachedEnd;
+                reachedEnd = -1;
             }
-            out << "  ]\n";
-
-            out << "  ,\"endpoints\": [\n";
-            for (size_t i = 0; i < endPoints.size(); ++i) {
-                EndPoint &ep = endPoints[i];
-                out << "    {\"x\":" << ep.position.x
-                    << ",\"y\":" << ep.position.y
-                    << ",\"w\":" << ep.size.x
-                    << ",\"h\":" << ep.size.y
-                    << ",\"toMenu\":" << (ep.goToMenu ? "true" : "false") << "}";
-                if (i + 1 < endPoints.size()) out << ",";
-                out << "\n";
+            if (end >= 0) leaveLevel(end);
+
+            if (!arrivingLevel.empty())
+            {
+                string path = "levels/" + arrivingLevel + ".json";
+                // the menu or the editor opened while waiting stays on the level left
+                if (inMenu || editMode) arrivingLevel.clear();
+                else if (prefetcher.ready(path) || !prefetcher.holds(path))
+                {
+                    string name = std::move(arrivingLevel);
+                    arrivingLevel.clear();
+                    enterLevel(name);
+                }
             }
-            out << "  ]\n";
 
-            out << "}\n";
+            if (!inMenu && !editMode && !playback.replay && arrivingLevel.empty()) resumeSimulation();
+            else pauseSimulation();
+        }
 
-            out.close();
-            return true;
+        // Parks the simulation thread, waiting out the step it is in. An endpoint it
+        // reached is dropped: the editor, the menu or a reloaded level takes over instead,
+        // and resuming on the endpoint reaches it again.
+        void pauseSimulation()
+        {
+            std::unique_lock<std::mutex> lock(simMutex);
+            simRun = false;
+            simWake.notify_all();
+            simIdle.wait(lock, [&] { return !simBusy; });
+            reachedEnd = -1;
         }
 
-        bool loadFromJson(const string &path)
+        void resumeSimulation()
+        {
+            std::lock_guard<std::mutex> lock(simMutex);
+            // an endpoint reached since runSimulation looked is left for its next call
+            if (simRun || reachedEnd >= 0) return;
+
+            // the thread is parked, so this thread can publish the state it starts from
+            simStart = std::chrono::steady_clock::now();
+            publishView(player.position, camera.target, simStart);
+            simRun = true;
+            simWake.notify_all();
+        }
+
+        // Edges wait in sharedInput until a step takes them, frames can run zero steps
+        // and several frames can pass in one
+        void submitInput(const InputState &input)
         {
-            ifstream in(path);
-            if (!in.is_open()) return false;
-            string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-            in.close();
-
-            // --- Load platforms ---
-            regex platformRegex("\\{\"x\":(.*?),\"y\":(.*?),\"w\":(.*?),\"h\":(.*?),\"visible\":(true|false)\\}");
-            sregex_iterator pit(content.begin(), content.end(), platformRegex);
-            sregex_iterator end;
-            vector<platform> newPlats;
-            for (; pit != end; ++pit)
+            std::lock_guard<std::mutex> lock(simMutex);
+            sharedInput.direction = input.direction;
+            sharedInput.jump = input.jump;
+            sharedInput.reset = input.reset;
+            if (input.hook)
             {
-                float x = stof((*pit)[1].str());
-                float y = stof((*pit)[2].str());
-                float w = stof((*pit)[3].str());
-                float h = stof((*pit)[4].str());
-                bool vis = ((*pit)[5].str() == "true");
-                newPlats.emplace_back(x, y, w, h, vis);
+                sharedInput.hook = true;
+                sharedInput.hookTarget = input.hookTarget;
             }
+            if (input.release) sharedInput.release = true;
+        }
+
+        // Publishes the state the last step left, blended into from and fromTarget
+        void publishView(Vector2 from, Vector2 fromTarget, std::chrono::steady_clock::time_point stepTime)
+        {
+            View &v = views.back();
+            v.previousPosition = from;
+            v.position = player.position;
+            v.previousTarget = fromTarget;
+            v.target = camera.target;
+            v.swinging = player.swinging;
+            v.anchor = player.anchor;
+            v.stepTime = stepTime;
+            v.hooks = hooks;
+            v.releases = releases;
+            v.resets = resets;
+            views.publish();
+        }
 
-            // --- Load spikes ---
-            regex spikeRegex("\\{\"x\":(.*?),\"y\":(.*?),\"size\":(.*?)\\}");
-            sregex_iterator sit(content.begin(), content.end(), spikeRegex);
-            vector<Spike> newSpikes;
-            for (; sit != end; ++sit)
+        void simulationLoop()
+        {
+            using clock = std::chrono::steady_clock;
+            std::unique_lock<std::mutex> lock(simMutex);
+            for (;;)
             {
-                float x = stof((*sit)[1].str());
-                float y = stof((*sit)[2].str());
-                float size = stof((*sit)[3].str());
-                newSpikes.emplace_back(x, y, size);
+                simWake.wait(lock, [&] { return simRun || simQuit; });
+                if (simQuit) return;
+                simBusy = true;
+
+                float fixedStep = 1.0f / simulationRate;
+                clock::duration stepLength = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(fixedStep));
+                clock::time_point next = simStart + stepLength;
+                // sleeps until the next step is due, unless asked to park
+                while (!simWake.wait_until(lock, next, [&] { return !simRun || simQuit; }))
+                {
+                    // drop the backlog after a long hitch instead of spiralling
+                    if (clock::now() - next > maxStepsPerFrame * stepLength) next = clock::now();
+
+                    pendingInput.direction = sharedInput.direction;
+                    pendingInput.jump = sharedInput.jump;
+                    pendingInput.reset = sharedInput.reset;
+                    if (sharedInput.hook)
+                    {
+                        pendingInput.hook = true;
+                        pendingInput.hookTarget = sharedInput.hookTarget;
+                    }
+                    if (sharedInput.release) pendingInput.release = true;
+                    sharedInput.hook = false;
+                    sharedInput.release = false;
+
+                    lock.unlock();
+                    Vector2 before = player.position;
+                    Vector2 beforeTarget = camera.target;
+                    StepEvents events = stepLive(fixedStep);
+                    // a respawn is a jump to draw at once, not a move to blend across
+                    if (player.respawned) publishView(player.position, camera.target, next);
+                    else publishView(before, beforeTarget, next);
+                    lock.lock();
+
+                    if (events.endPoint >= 0)
+                    {
+                        reachedEnd = events.endPoint;
+                        simRun = false;
+                        break;
+                    }
+                    next += stepLength;
+                }
+
+                simBusy = false;
+                simIdle.notify_all();
             }
+        }
+
+        // Draws the player and camera where they are from now on, without blending in
+        // from before: for loads, respawns and the editor
+        void snapView()
+        {
+            previousPosition = player.position;
+            previousTarget = camera.target;
+        }
+
+        // For when the level's objects were replaced: play mode's batches are built
+        // again on the next draw and its tiles as they come on screen
+        void levelChanged()
+        {
+            batch.dirty = true;
+            tiles.clear();
+            fillEndCells();
+        }
+
+        // For an editor change to a platform or spike inside area
+        void edited(Rectangle area)
+        {
+            batch.dirty = true;
+            tiles.invalidate(area);
+        }
 
-            regex endRegex("\\{\"x\":(.*?),\"y\":(.*?),\"w\":(.*?),\"h\":(.*?),\"toMenu\":(true|false)\\}");
-            sregex_iterator eit(content.begin(), content.end(), endRegex);
-            vector<EndPoint> newEnds;
-            for (; eit != end; ++eit)
+        // Renders the tiles the next draw() needs, before BeginDrawing
+        void prepareDraw()
+        {
+            if (editMode) return;
+            if (batch.dirty) batch.build(*this);
+            tiles.prepare(cameraView(8), batch, [&](Rectangle area)
+            {
+                return touchesPlatform(area) || touches(collision.spikes, collision.spikeRects, area);
+            });
+        }
+
+        // Levels have a handful of endpoints, so their grid is simply filled again
+        void fillEndCells()
+        {
+            endCells.clear();
+            for (int i = 0; i < (int)endPoints.size(); ++i) endCells.insert(i, endPoints[i].getRect());
+        }
+
+        // for endpoint i added or moved in the editor
+        void placeEndPoint(int i)
+        {
+            collision.setEndPoint(i, endPoints[i]);
+            batch.dirty = true;
+            fillEndCells();
+        }
+
+        void reset(Sound resetSound)
+        {
+            PlaySound(resetSound);
+            player.respawn();
+        }
+
+        // The editor changes the collision index object by object, play mode uses it baked
+        void setEditMode(bool on)
+        {
+            editMode = on;
+            snapView();
+            bool wantBaked = bakeGeometry && !editMode;
+            if (collision.baked != wantBaked)
             {
-                float x = stof((*eit)[1].str());
-                float y = stof((*eit)[2].str());
-                float w = stof((*eit)[3].str());
-                float h = stof((*eit)[4].str());
-                bool toMenu = ((*eit)[5].str() == "true");
-                newEnds.emplace_back(x, y, w, h, toMenu);
+                if (wantBaked) compileCollision();
+                else rebuildCollision();
             }
+        }
 
-            platforms = std::move(newPlats);
-            spikes = std::move(newSpikes);
-            endPoints = std::move(newEnds);
+        bool loadFromJson(const string &path)
+        {
+            if (!prefetcher.take(path, *this) && !Simulation::loadFromJson(path)) return false;
+            // loads come baked, or as the prefetch that made them built them
+            setEditMode(editMode);
+            levelChanged();
+            reloader.cancel();
             selectedIndex = -1;
+            levelPath = path;
+            segmentPending = !editMode;
+            snapView();
+            recorder.end();
+
+            if (path == "levels/" + currentLevelName + ".json")
+            {
+                auto it = std::find(levelOrder.begin(), levelOrder.end(), currentLevelName);
+                if (it != levelOrder.end() && ++it != levelOrder.end()) prefetcher.prefetch("levels/" + *it + ".json");
+            }
             return true;
         }
+
+        // Picks up level files levelWatcher saw change. The current level is read again on
+        // levelIo and swapped in once it has loaded, with the player left where it is; a
+        // prefetched copy of another level is loaded again. While the editor is open its
+        // level is what counts, and during replays the recorded files are.
+        void reloadChangedLevels()
+        {
+            vector<string> changed;
+            if (levelWatcher.poll(changed))
+            {
+                for (auto &path : changed)
+                {
+                    if (path.size() < 5 || path.compare(path.size() - 5, 5, ".json") != 0) continue;
+                    if (path == levelPath && !editMode && !playback.replay)
+                    {
+                        reloader.cancel();
+                        reloader.prefetch(path);
+                    }
+                    else if (prefetcher.holds(path))
+                    {
+                        prefetcher.cancel();
+                        prefetcher.prefetch(path);
+                    }
+                }
+            }
+
+            if (!reloader.ready(levelPath)) return;
+            // runSimulation starts it again next frame; pausing also drops an endpoint of
+            // the old level it may have reached
+            pauseSimulation();
+            if (!reloader.take(levelPath, *this))
+            {
+                TraceLog(LOG_WARNING, "RELOAD: could not load %s, keeping the level as it was", levelPath.c_str());
+                return;
+            }
+            setEditMode(editMode);
+            levelChanged();
+            // the rope stays on if what it hangs from is still there
+            if (player.swinging && !touchesPlatform({player.anchor.x - 1, player.anchor.y - 1, 2, 2})) player.releaseRope();
+            // the recording continues as a new segment on the new file
+            recorder.end();
+            segmentPending = true;
+            TraceLog(LOG_INFO, "RELOAD: %s changed on disk, reloaded", levelPath.c_str());
+        }
+
+        bool touchesPlatform(Rectangle area)
+        {
+            return touches(collision.platforms, collision.platformRects, area);
+        }
+
+        bool touches(const SpatialGrid &grid, const RectSoA &rects, Rectangle area)
+        {
+            grid.query(area, picked);
+            for (int i : picked)
+                if (rectsOverlap(rects.get(i), area)) return true;
+            return false;
+        }
+
+        // Saves a copy of the level in the background, saver.poll() reports when it is written
+        void saveInBackground(const string &path)
+        {
+            // the prefetched copy may be of the file being overwritten
+            prefetcher.cancel();
+            saver.save(*this, path);
+        }
 };
 
 vector<string> getLevelFiles()
@@ -950,11 +1635,10 @@ vector<string> getLevelFiles()
     return files;
 }
 
-int main () {
+int main (int argc, char **argv) {
 
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(screenWidth, screenHeight, "Hookle");
-    SetTargetFPS(60);
 
     Game game = Game();
     game.gameStart();
@@ -973,6 +1657,9 @@ int main () {
     Sound endSound = LoadSound("sounds/end.mp3");
     SetSoundVolume(endSound, .2);
     game.endSound = endSound;
+    game.launchSound = launchSound;
+    game.releaseSound = releaseSound;
+    game.resetSound = resetSound;
 
     Music music = LoadMusicStream("sounds/music.mp3");
     SetMusicVolume(music, .2f);
@@ -990,6 +1677,25 @@ int main () {
 
     //game.loadFromJson("levels/tutorial.json");
     game.loadFromJson("levels/blank.json");
+    if (!game.levelWatcher.start("levels")) TraceLog(LOG_INFO, "RELOAD: not watching levels/, edits on disk need a reload");
+
+    // --deterministic plays in fixed-point, --replay <file> plays a recorded session back in real time,
+    // --fps <n> caps the frame rate at n (0 for uncapped) instead of the monitor's refresh rate
+    int targetFps = GetMonitorRefreshRate(GetCurrentMonitor());
+    if (targetFps <= 0) targetFps = 60;
+    Replay replay;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--deterministic") game.deterministic = true;
+        else if (arg == "--fps" && i + 1 < argc) targetFps = atoi(argv[++i]);
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            if (replay.load(argv[++i])) game.startPlayback(replay);
+            else TraceLog(LOG_WARNING, "REPLAY: could not load %s", argv[i]);
+        }
+    }
+    SetTargetFPS(targetFps);
 
     bool showSaveBox = false;
     bool showLoadBox = false;
@@ -1004,18 +1710,23 @@ int main () {
     {
         if (IsKeyPressed(KEY_E) && !blockInput && allowEditor)
         {
-            game.editMode = !game.editMode;
+            game.pauseSimulation();
+            game.setEditMode(!game.editMode);
             game.currentAction = NONE;
+            // edits make the level differ from its file, so the recording stops here
+            if (game.editMode) game.recorder.end();
             game.selectedIndex = -1;
         }
 
         if (IsKeyPressed(KEY_TAB) && !inMenu)
         {
+            game.pauseSimulation();
             blockInput = true;
             inMenu = true;
             allowEditor = false;
             game.reset(resetSound);
-            game.editMode = false;
+            game.setEditMode(false);
+            game.playback = ReplayCursor();
         }
 
         if (IsKeyPressed(KEY_O) && game.editMode && !blockInput)
@@ -1032,13 +1743,17 @@ int main () {
             {
                 if (game.selectedIndex >= 0 && game.selectedIndex < (int)game.platforms.size())
                 {
+                    game.edited(game.platforms[game.selectedIndex].getRect());
                     game.platforms.erase(game.platforms.begin() + game.selectedIndex);
                     game.selectedIndex = -1;
+                    game.rebuildCollision();
                 }
                 else if (game.selectedSpikeIndex >= 0 && game.selectedSpikeIndex < (int)game.spikes.size())
                 {
+                    game.edited(game.spikes[game.selectedSpikeIndex].getRect());
                     game.spikes.erase(game.spikes.begin() + game.selectedSpikeIndex);
                     game.selectedSpikeIndex = -1;
+                    game.rebuildCollision();
                 }
             }
         }
@@ -1050,61 +1765,25 @@ int main () {
             PlayMusicStream(music);
         }
 
+        InputState input;
         if (!game.editMode)
         {
-            if (game.player.position.y > 1000)
-            {
-                game.reset(resetSound);
-            }
-
-            if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W) && !blockInput) game.player.jump();
-            if (IsKeyDown(KEY_R) && !blockInput) game.reset(resetSound);
-            if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A) && !blockInput) game.player.direction = -1;
-            else if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D) && !blockInput) game.player.direction = 1;
-            else game.player.direction = 0;
+            if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W) && !blockInput) input.jump = true;
+            if (IsKeyDown(KEY_R) && !blockInput) input.reset = true;
+            if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A) && !blockInput) input.direction = -1;
+            else if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D) && !blockInput) input.direction = 1;
+            else input.direction = 0;
 
             if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !blockInput)
             {
-                Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), game.camera);
-                game.player.anchor = mouseWorld;
-
-                Vector2 diff = Vector2Subtract(game.player.position, game.player.anchor);
-                game.player.ropeLength = Vector2Length(diff);
-                game.player.ropeAngle = atan2f(diff.y, diff.x);
-
-                if (game.player.ropeLength != 0)
-                {
-                    Vector2 tangent = { -diff.y / game.player.ropeLength, diff.x / game.player.ropeLength };
-                    game.player.angularVelocity = (game.player.xVelocity * tangent.x + game.player.yVelocity * tangent.y) / game.player.ropeLength;
-                }
-
-                PlaySound(launchSound);
-                game.player.swinging = true;
+                input.hook = true;
+                // aimed at what is on screen, which is the blended view
+                input.hookTarget = GetScreenToWorld2D(GetMousePosition(), game.shownCamera);
             }
 
             if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && !blockInput)
             {
-                if (game.player.swinging) 
-                {
-                    Vector2 toPlayer = Vector2Subtract(game.player.position, game.player.anchor);
-                    float len = Vector2Length(toPlayer);
-
-                    if (len != 0)
-                    {
-                        Vector2 tangent = { -toPlayer.y / len, toPlayer.x / len };
-
-                        float speed = game.player.angularVelocity * game.player.ropeLength;
-                        game.player.xVelocity = tangent.x * speed / 35;
-                        game.player.yVelocity = tangent.y * speed;
-
-                        if (abs(speed) > 1)
-                        {
-                            PlaySound(releaseSound);
-                        }
-                    }
-                }
-
-                game.player.swinging = false;
+                input.release = true;
             }
         }
         else
@@ -1127,7 +1806,11 @@ int main () {
             }
         }
 
-        if (!inMenu) {game.update();}
+        if (!inMenu) {game.update(input);}
+        game.runSimulation();
+        game.updateView();
+        if (inMenu) game.finishRecording();
+        else game.prepareDraw();
 
         BeginDrawing();
 
@@ -1149,7 +1832,8 @@ int main () {
                     if (btn.text == "Play") {
                         inMenu = false;
                         blockInput = false;
-                        game.loadFromJson("levels/tutorial.json");
+                        game.currentLevelName = game.levelOrder.front();
+                        game.loadFromJson("levels/" + game.currentLevelName + ".json");
                     }
                     else if (btn.text == "Sandbox") {
                         inMenu = false;
@@ -1167,11 +1851,19 @@ int main () {
         {
             ClearBackground(white);
 
-            BeginMode2D(game.camera);
+            BeginMode2D(game.shownCamera);
 
             game.draw();
 
             EndMode2D();
+
+            if (game.editMode)
+                DrawText(TextFormat("drawn %d | culled %d", game.drawnObjects, game.culledObjects),
+                         10, GetScreenHeight() - 28, 18, black);
+            else
+                DrawText(TextFormat("tiles %d (%d cached) | endpoints drawn %d, culled %d", game.tiles.drawnTiles,
+                                    game.tiles.residentTiles(), game.drawnObjects, game.culledObjects),
+                         10, GetScreenHeight() - 28, 18, black);
         }
 
         if (allowEditor)
@@ -1199,14 +1891,19 @@ int main () {
             {
                 showSaveBox = false;
                 blockInput = false;
-                if (result == 1)
-                {
-                    game.saveToJson("levels/" + (string)userSaveBuffer + ".json");
-                    PlaySound(saveSound);
-                }
+                if (result == 1) game.saveInBackground("levels/" + (string)userSaveBuffer + ".json");
             }
         }
 
+        game.reloadChangedLevels();
+
+        LevelSaver::Result saved;
+        while (game.saver.poll(saved))
+        {
+            if (saved.ok) PlaySound(saveSound);
+            else TraceLog(LOG_WARNING, "SAVE: could not write %s", saved.path.c_str());
+        }
+
         if (showLoadBox)
         {
             Vector2 size = {700, 400};
@@ -1271,6 +1968,9 @@ int main () {
         EndDrawing();
     }
 
+    game.pauseSimulation();
+    game.finishRecording();
+
     UnloadSound(resetSound);
     UnloadSound(releaseSound);
     UnloadSound(launchSound);
@@ -1283,6 +1983,8 @@ int main () {
     UnloadMusicStream(music);
     CloseAudioDevice();
     
+    game.tiles.clear();
+    game.batch.clear();
     CloseWindow();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory map of a whole file. Kept in its own translation unit without
+// raylib.h, since windows.h cannot be included next to it.
+class MappedFile
+{
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Fails for missing or empty files
+        bool open(const std::string &path);
+        void close();
+
+        const unsigned char *data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const unsigned char *bytes = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        void *file = nullptr;
+        void *mapping = nullptr;
+#endif
+};
@@ -0,0 +1,110 @@
+#include <cstring>
+#include "parallelload.h"
+#include "levelparser.h"
+
+using namespace std;
+
+namespace
+{
+    struct Chunk
+    {
+        int array;
+        const char *begin;
+        const char *limit;
+        const char *end;
+        bool ok = false;
+        vector<platform> plats;
+        vector<Spike> spks;
+        vector<EndPoint> ends;
+    };
+
+    // Cuts one array into about parts chunks, each starting at the first '{' after an
+    // even split. Records are flat objects, so that is a record start unless a string
+    // or an unknown nested field got in the way, which the chunk before then catches.
+    void split(int array, LevelParser::Span span, size_t parts, vector<Chunk> &chunks)
+    {
+        size_t size = span.end - span.begin;
+        parts = max<size_t>(1, min(parts, size / parallelChunkBytes));
+
+        const char *start = span.begin;
+        for (size_t k = 1; k <= parts; ++k)
+        {
+            const char *limit = span.end;
+            if (k < parts)
+            {
+                const char *guess = span.begin + size * k / parts;
+                if (guess <= start) continue;
+                const void *brace = memchr(guess, '{', span.end - guess);
+                if (!brace) continue;
+                limit = (const char *)brace;
+            }
+            Chunk c;
+            c.array = array;
+            c.begin = start;
+            c.limit = limit;
+            c.end = span.end;
+            chunks.push_back(std::move(c));
+            start = limit;
+        }
+    }
+
+    template <typename T>
+    bool parseChunk(const Chunk &c, vector<T> &out)
+    {
+        // spikes, the shortest records saveToJson writes, take about 48 bytes
+        out.reserve((c.limit - c.begin) / 48);
+        return LevelParser(c.begin, c.end).records(c.limit, out);
+    }
+
+    // Appends the records the chunks of one array parsed, in file order
+    template <typename T>
+    void join(const vector<Chunk> &chunks, int array, vector<T> Chunk::*part, vector<T> &out)
+    {
+        size_t total = out.size();
+        for (auto &c : chunks) if (c.array == array) total += (c.*part).size();
+        out.reserve(total);
+        for (auto &c : chunks)
+            if (c.array == array) out.insert(out.end(), (c.*part).begin(), (c.*part).end());
+    }
+}
+
+bool parseLevelParallel(const char *begin, const char *end, ThreadPool &pool,
+                        vector<platform> &plats, vector<Spike> &spks, vector<EndPoint> &ends)
+{
+    LevelParser::Span spans[3];
+    if (LevelParser(begin, end).locate(spans[0], spans[1], spans[2]))
+    {
+        // a few chunks per worker so uneven ones even out
+        size_t parts = (size_t)pool.size() * 4;
+        vector<Chunk> chunks;
+        for (int a = 0; a < 3; ++a)
+            if (spans[a].begin) split(a, spans[a], parts, chunks);
+
+        pool.parallelFor((int)chunks.size(), 1, [&](int first, int last, int)
+        {
+            for (int i = first; i < last; ++i)
+            {
+                Chunk &c = chunks[i];
+                if (c.array == 0) c.ok = parseChunk(c, c.plats);
+                else if (c.array == 1) c.ok = parseChunk(c, c.spks);
+                else c.ok = parseChunk(c, c.ends);
+            }
+        });
+
+        bool aligned = true;
+        for (auto &c : chunks) aligned = aligned && c.ok;
+        if (aligned)
+        {
+            join(chunks, 0, &Chunk::plats, plats);
+            join(chunks, 1, &Chunk::spks, spks);
+            join(chunks, 2, &Chunk::ends, ends);
+            return true;
+        }
+    }
+
+    // malformed, or a chunk started mid-record: the serial parser has the final word
+    plats.clear();
+    spks.clear();
+    ends.clear();
+    return LevelParser(begin, end).parse(plats, spks, ends);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <vector>
+#include "simulation.h"
+#include "threadpool.h"
+
+// parseLevelParallel cuts no chunk smaller than this, so a level under two of them is
+// parsed serially by Simulation::loadFromJson even when it has a parsePool
+const size_t parallelChunkBytes = 256 * 1024;
+
+// Parses level JSON held in memory over a thread pool. The three arrays are located
+// first, cut into chunks at guessed record starts and the chunks parsed in parallel,
+// then joined in order. Each chunk must end exactly where the next begins; if any
+// guess was wrong the whole level is parsed again serially, so the result is always
+// exactly that of LevelParser::parse.
+bool parseLevelParallel(const char *begin, const char *end, ThreadPool &pool,
+                        std::vector<platform> &plats, std::vector<Spike> &spks, std::vector<EndPoint> &ends);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include "simulation.h"
+#include "threadpool.h"
+
+// Loads a level ahead of time on a background thread: parsed and with its collision
+// index built, ready to be swapped into the running simulation. Jobs run on the
+// given pool, which is best a single thread shared with LevelSaver so that loads
+// and saves happen in the order they were asked for.
+class LevelPrefetcher
+{
+    public:
+        // parsePool, when given, parses large levels for the loads; it must not be pool
+        LevelPrefetcher(ThreadPool &pool, ThreadPool *parsePool = nullptr) : worker(pool), parsePool(parsePool) {}
+
+        // Starts loading path in the background unless it is already loaded or loading
+        void prefetch(const std::string &path)
+        {
+            if (slot && slot->path == path) return;
+
+            auto next = std::make_shared<Slot>();
+            next->path = path;
+            next->level.parsePool = parsePool;
+            slot = next;
+            // a replaced slot finishes loading on its own and is dropped
+            worker.submit([next](int)
+            {
+                bool ok = next->level.loadFromJson(next->path);
+                std::lock_guard<std::mutex> lock(next->mutex);
+                next->ok = ok;
+                next->done = true;
+                next->finished.notify_all();
+            });
+        }
+
+        // Hands the prefetched level over to sim if it is path, waiting for the load
+        // if it is still running. False if path was not prefetched or did not load.
+        bool take(const std::string &path, Simulation &sim)
+        {
+            if (!slot || slot->path != path) return false;
+
+            std::shared_ptr<Slot> taken = std::move(slot);
+            {
+                std::unique_lock<std::mutex> lock(taken->mutex);
+                taken->finished.wait(lock, [&] { return taken->done; });
+            }
+            if (!taken->ok) return false;
+            sim.swapLevel(taken->level);
+
+            // the level swapped out is freed on the worker too
+            worker.submit([old = std::move(taken)](int) {});
+            return true;
+        }
+
+        // True once the load of path has finished, so take() will not wait for it
+        bool ready(const std::string &path)
+        {
+            if (!slot || slot->path != path) return false;
+            std::lock_guard<std::mutex> lock(slot->mutex);
+            return slot->done;
+        }
+
+        bool holds(const std::string &path) const
+        {
+            return slot && slot->path == path;
+        }
+
+        // Forgets the prefetched level, for when its file changed
+        void cancel()
+        {
+            slot.reset();
+        }
+
+    private:
+        struct Slot
+        {
+            std::string path;
+            Simulation level;
+            bool done = false;
+            bool ok = false;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+
+        ThreadPool &worker;
+        ThreadPool *parsePool;
+        std::shared_ptr<Slot> slot;
+};
@@ -0,0 +1,321 @@
+#include <fstream>
+#include <cstring>
+#include "replay.h"
+
+using namespace std;
+
+const char replayMagic[4] = {'H', 'K', 'R', 'P'};
+const int replayVersion = 3;
+
+uint64_t playerStateHash(const Player &p)
+{
+    float fields[] = {p.position.x, p.position.y, p.xVelocity, p.yVelocity,
+                      p.anchor.x, p.anchor.y, p.ropeLength, p.ropeAngle, p.angularVelocity};
+    uint64_t h = 14695981039346656037ull;
+    auto feed = [&h](const void *data, size_t size)
+    {
+        const unsigned char *bytes = (const unsigned char *)data;
+        for (size_t i = 0; i < size; ++i)
+        {
+            h ^= bytes[i];
+            h *= 1099511628211ull;
+        }
+    };
+    feed(fields, sizeof(fields));
+    unsigned char flags = (p.swinging ? 1 : 0) | (p.canJump ? 2 : 0);
+    feed(&flags, 1);
+    return h;
+}
+
+// --- Encoding ---
+
+static void putVarint(string &out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+static void putFloat(string &out, float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+    for (int i = 0; i < 4; ++i) out.push_back((char)(bits >> (8 * i)));
+}
+
+struct Reader
+{
+    const string &data;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint64_t varint()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos >= data.size()) { ok = false; return 0; }
+            unsigned char b = data[pos++];
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    // A count of items that take at least a byte each, so no more than the bytes left
+    size_t count()
+    {
+        uint64_t n = varint();
+        if (n > data.size() - pos) { ok = false; return 0; }
+        return (size_t)n;
+    }
+
+    float f32()
+    {
+        if (pos + 4 > data.size()) { ok = false; return 0; }
+        uint32_t bits = 0;
+        for (int i = 0; i < 4; ++i) bits |= (uint32_t)(unsigned char)data[pos++] << (8 * i);
+        float f;
+        memcpy(&f, &bits, 4);
+        return f;
+    }
+};
+
+// input flags: bits 0-1 direction + 1, then jump, hook, release, reset
+static unsigned inputFlags(const InputState &in)
+{
+    return (unsigned)(in.direction + 1) | (in.jump << 2) | (in.hook << 3) | (in.release << 4) | (in.reset << 5);
+}
+
+static void putPlayer(string &out, const Player &p)
+{
+    for (float f : {p.position.x, p.position.y, p.xVelocity, p.yVelocity, p.anchor.x, p.anchor.y,
+                    p.ropeLength, p.ropeAngle, p.angularVelocity})
+        putFloat(out, f);
+    putVarint(out, (p.swinging ? 1 : 0) | (p.canJump ? 2 : 0));
+}
+
+static Player readPlayer(Reader &r)
+{
+    Player p;
+    p.position.x = r.f32(); p.position.y = r.f32();
+    p.xVelocity = r.f32(); p.yVelocity = r.f32();
+    p.anchor.x = r.f32(); p.anchor.y = r.f32();
+    p.ropeLength = r.f32(); p.ropeAngle = r.f32(); p.angularVelocity = r.f32();
+    unsigned flags = (unsigned)r.varint();
+    p.swinging = flags & 1;
+    p.canJump = flags & 2;
+    return p;
+}
+
+bool Replay::save(const string &path) const
+{
+    string out(replayMagic, 4);
+    putVarint(out, replayVersion);
+    putVarint(out, simulationRate);
+    putVarint(out, (deterministic ? 1 : 0) | (bakedGeometry ? 2 : 0));
+    putVarint(out, segments.size());
+    for (auto &seg : segments)
+    {
+        putVarint(out, seg.level.size());
+        out += seg.level;
+        putPlayer(out, seg.start);
+        putVarint(out, seg.endHash);
+        putVarint(out, seg.runs.size());
+        for (auto &run : seg.runs)
+        {
+            putVarint(out, run.count);
+            putVarint(out, inputFlags(run.input));
+            if (run.input.hook)
+            {
+                putFloat(out, run.input.hookTarget.x);
+                putFloat(out, run.input.hookTarget.y);
+            }
+        }
+    }
+
+    ofstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    file.write(out.data(), out.size());
+    return (bool)file;
+}
+
+bool Replay::load(const string &path)
+{
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    if (data.size() < 4 || memcmp(data.data(), replayMagic, 4) != 0) return false;
+
+    Reader r{data, 4};
+    // version 1 predates the deterministic mode flag, version 2 the baked geometry one
+    uint64_t version = r.varint();
+    if (version < 1 || version > replayVersion) return false;
+    simulationRate = (int)r.varint();
+    if (simulationRate <= 0) return false;
+    uint64_t modes = version >= 2 ? r.varint() : 0;
+    deterministic = modes & 1;
+    bakedGeometry = version >= 3 && (modes & 2);
+
+    segments.assign(r.count(), ReplaySegment());
+    if (!r.ok) return false;
+    for (auto &seg : segments)
+    {
+        uint64_t len = r.varint();
+        if (!r.ok || len > data.size() - r.pos) return false;
+        seg.level = data.substr(r.pos, len);
+        r.pos += len;
+        seg.start = readPlayer(r);
+        seg.endHash = r.varint();
+
+        seg.runs.assign(r.count(), InputRun());
+        if (!r.ok) return false;
+        for (auto &run : seg.runs)
+        {
+            run.count = (uint32_t)r.varint();
+            unsigned flags = (unsigned)r.varint();
+            run.input.direction = (int)(flags & 3) - 1;
+            run.input.jump = flags & 4;
+            run.input.hook = flags & 8;
+            run.input.release = flags & 16;
+            run.input.reset = flags & 32;
+            if (run.input.hook)
+            {
+                run.input.hookTarget.x = r.f32();
+                run.input.hookTarget.y = r.f32();
+            }
+            seg.steps += run.count;
+        }
+        if (!r.ok) return false;
+    }
+    return r.ok;
+}
+
+uint64_t Replay::totalSteps() const
+{
+    uint64_t total = 0;
+    for (auto &seg : segments) total += seg.steps;
+    return total;
+}
+
+// --- Recording ---
+
+void ReplayRecorder::begin(const string &level, const Player &start, int simulationRate, bool deterministic, bool bakedGeometry)
+{
+    if (replay.segments.empty())
+    {
+        replay.simulationRate = simulationRate;
+        replay.deterministic = deterministic;
+        replay.bakedGeometry = bakedGeometry;
+    }
+    ReplaySegment seg;
+    seg.level = level;
+    seg.start = start;
+    seg.endHash = playerStateHash(start);
+    replay.segments.push_back(seg);
+    recording = true;
+}
+
+void ReplayRecorder::record(const InputState &input)
+{
+    if (!recording) return;
+    ReplaySegment &seg = replay.segments.back();
+    seg.steps++;
+
+    // edges never merge, held input extends the current run
+    if (!seg.runs.empty() && !input.hook && !input.release)
+    {
+        InputRun &last = seg.runs.back();
+        if (!last.input.hook && !last.input.release && inputFlags(last.input) == inputFlags(input))
+        {
+            last.count++;
+            return;
+        }
+    }
+    seg.runs.push_back({input, 1});
+}
+
+void ReplayRecorder::stepped(const Player &after)
+{
+    if (recording) replay.segments.back().endHash = playerStateHash(after);
+}
+
+void ReplayRecorder::end()
+{
+    recording = false;
+}
+
+// --- Playback ---
+
+void ReplayCursor::reset(const Replay &r)
+{
+    replay = &r;
+    segment = 0;
+    run = 0;
+    offset = 0;
+    // skip segments without input
+    while (segment < (int)replay->segments.size() && replay->segments[segment].runs.empty()) segment++;
+}
+
+bool ReplayCursor::done() const
+{
+    return !replay || segment >= (int)replay->segments.size();
+}
+
+bool ReplayCursor::atSegmentStart() const
+{
+    return run == 0 && offset == 0;
+}
+
+const ReplaySegment &ReplayCursor::currentSegment() const
+{
+    return replay->segments[segment];
+}
+
+InputState ReplayCursor::next()
+{
+    const ReplaySegment &seg = replay->segments[segment];
+    InputState input = seg.runs[run].input;
+    if (++offset >= seg.runs[run].count)
+    {
+        offset = 0;
+        if (++run >= (int)seg.runs.size())
+        {
+            run = 0;
+            segment++;
+            while (segment < (int)replay->segments.size() && replay->segments[segment].runs.empty()) segment++;
+        }
+    }
+    return input;
+}
+
+bool playReplay(const Replay &replay, Simulation &sim, string *error)
+{
+    float fixedStep = 1.0f / replay.simulationRate;
+    sim.deterministic = replay.deterministic;
+    sim.bakeGeometry = replay.bakedGeometry;
+    for (size_t s = 0; s < replay.segments.size(); ++s)
+    {
+        const ReplaySegment &seg = replay.segments[s];
+        if (!sim.loadFromJson(seg.level))
+        {
+            if (error) *error = "could not load " + seg.level;
+            return false;
+        }
+        sim.player = seg.start;
+
+        for (auto &run : seg.runs)
+            for (uint32_t i = 0; i < run.count; ++i) sim.step(run.input, fixedStep);
+
+        if (playerStateHash(sim.player) != seg.endHash)
+        {
+            if (error) *error = "segment " + to_string(s) + " (" + seg.level + ") diverged from the recording";
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "simulation.h"
+
+// Input logs of play sessions, re-simulated step for step by the headless core.
+//
+// A replay is a list of segments, one per level played: the level file, the player
+// state when it started, and the input fed to every fixed step as runs of identical
+// input. Files are varint encoded, floats are stored bit-exact.
+
+// Bit-exact hash of the player's physics state
+uint64_t playerStateHash(const Player &p);
+
+struct InputRun
+{
+    InputState input;
+    uint32_t count;
+};
+
+struct ReplaySegment
+{
+    std::string level;
+    Player start;
+    std::vector<InputRun> runs;
+    uint64_t steps = 0;
+    uint64_t endHash = 0; // playerStateHash after the last step when recorded
+};
+
+class Replay
+{
+    public:
+        int simulationRate = 120;
+        bool deterministic = false; // recorded with Simulation::deterministic
+        bool bakedGeometry = false; // recorded with Simulation::bakeGeometry
+        std::vector<ReplaySegment> segments;
+
+        bool save(const std::string &path) const;
+        bool load(const std::string &path);
+        uint64_t totalSteps() const;
+};
+
+class ReplayRecorder
+{
+    public:
+        Replay replay;
+        bool recording = false;
+
+        void begin(const std::string &level, const Player &start, int simulationRate, bool deterministic, bool bakedGeometry);
+        void record(const InputState &input);
+        void stepped(const Player &after);
+        void end();
+};
+
+// Walks the inputs of a replay step by step
+class ReplayCursor
+{
+    public:
+        const Replay *replay = nullptr;
+        int segment = 0;
+        int run = 0;
+        uint32_t offset = 0;
+
+        void reset(const Replay &r);
+        bool done() const;
+        bool atSegmentStart() const;
+        const ReplaySegment &currentSegment() const;
+        InputState next();
+};
+
+// Plays the whole replay headless into sim as fast as possible, in the replay's modes. Returns false if a
+// level fails to load or a segment ends in a different state than it was recorded in.
+bool playReplay(const Replay &replay, Simulation &sim, std::string *error = nullptr);
@@ -0,0 +1,1276 @@
+#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include "simulation.h"
+#include "fixedmath.h"
+#include "levelparser.h"
+#include "levelformat.h"
+#include "parallelload.h"
+#include "raymath.h"
+
+using namespace std;
+
+void Player::update(const CollisionIndex& index, float deltaTime)
+{
+    // fast swings and releases are split into sub-steps, the common case stays one step
+    float travel = swinging ? fabs(angularVelocity) * ropeLength * deltaTime
+                            : sqrtf(xVelocity * playerSpeed * xVelocity * playerSpeed + yVelocity * yVelocity) * deltaTime;
+    int subSteps = 1;
+    if (travel > maxStepTravel) subSteps = min((int)ceilf(travel / maxStepTravel), maxSubSteps);
+
+    for (int i = 0; i < subSteps; ++i) integrate(index, deltaTime / subSteps);
+
+    wasSwingingLastFrame = swinging;
+}
+
+void Player::integrate(const CollisionIndex& index, float deltaTime)
+{
+    // rescale the per-step damping so behaviour matches the 60 Hz tuning at any step rate
+    float stepScale = deltaTime * referenceRate;
+    float stepFriction = powf(friction, stepScale);
+    float stepAccel = friction * (1 - stepFriction) / (stepFriction * (1 - friction));
+
+    if (swinging) {
+        float g = 1300.0f;
+        float angularAccel = -(g / ropeLength) * sinf(ropeAngle - PI/2);
+
+        angularAccel -= direction * 2.0f;
+
+        angularVelocity += angularAccel * deltaTime;
+        angularVelocity *= powf(ropeDamping, stepScale);
+        ropeAngle += angularVelocity * deltaTime;
+
+        position.x = anchor.x + ropeLength * cosf(ropeAngle);
+        position.y = anchor.y + ropeLength * sinf(ropeAngle);
+    } else {
+        xVelocity = (xVelocity + direction * stepAccel) * stepFriction;
+        yVelocity += gravity * deltaTime;
+        sweepMove(index, {xVelocity * deltaTime * playerSpeed, yVelocity * deltaTime});
+    }
+
+
+    canJump = landed;
+    landed = false;
+
+    Rectangle playerRect = {position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize};
+    index.platforms.query(playerRect, nearby);
+    nearbyRects.gather(index.platformRects, nearby);
+    for (int base = 0; base < nearbyRects.count; base += overlapLanes)
+    {
+        unsigned mask = overlapMask(nearbyRects, base, playerRect);
+        while (mask)
+        {
+            int lane = __builtin_ctz(mask);
+            mask &= mask - 1;
+
+            Rectangle platRect = nearbyRects.get(base + lane);
+            Vector2 before = position;
+
+            float overlapLeft   = (playerRect.x + playerRect.width) - platRect.x;
+            float overlapRight  = (platRect.x + platRect.width) - playerRect.x;
+            float overlapTop    = (playerRect.y + playerRect.height) - platRect.y;
+            float overlapBottom = (platRect.y + platRect.height) - playerRect.y;
+            float minOverlapX = (overlapLeft < overlapRight) ? overlapLeft : -overlapRight;
+            float minOverlapY = (overlapTop < overlapBottom) ? overlapTop : -overlapBottom;
+
+            if (!swinging)
+            {
+                if (abs(minOverlapX) < abs(minOverlapY))
+                {
+                    position.x -= minOverlapX;
+                    xVelocity = 0;
+                }
+                else
+                {
+                    position.y -= minOverlapY;
+                    yVelocity = 0;
+                    if (minOverlapY > 0)
+                    {
+                        canJump = true;
+                    }
+                }
+            }
+            else
+            {
+                if (fabs(angularVelocity) < 1.0f)
+                    {
+                        angularVelocity = 0;
+                        swinging = false;
+                        xVelocity = 0;
+                        yVelocity = 0;
+
+                        if (abs(minOverlapX) < abs(minOverlapY))
+                            position.x -= minOverlapX;
+                        else
+                            position.y -= minOverlapY;
+                    }
+                else
+                {
+                    angularVelocity = -angularVelocity * .95f;
+                }
+            }
+
+            // the push-out can move the player into or out of the rest of this block
+            if (position.x != before.x || position.y != before.y)
+            {
+                playerRect = {position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize};
+                mask = overlapMask(nearbyRects, base, playerRect) & ~((2u << lane) - 1);
+            }
+        }
+    }
+
+    index.spikes.query(playerRect, nearby);
+    nearbyRects.gather(index.spikeRects, nearby);
+    for (int base = 0; base < nearbyRects.count; base += overlapLanes)
+    {
+        unsigned mask = overlapMask(nearbyRects, base, playerRect);
+        while (mask)
+        {
+            int lane = __builtin_ctz(mask);
+            mask &= mask - 1;
+
+            respawn();
+
+            playerRect = {position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize};
+            mask = overlapMask(nearbyRects, base, playerRect) & ~((2u << lane) - 1);
+        }
+    }
+}
+
+// Moves by delta, stopping at the first platform face crossed on the way and
+// sliding along it, so a fast player cannot pass through thin geometry
+void Player::sweepMove(const CollisionIndex& index, Vector2 delta)
+{
+    for (int iteration = 0; iteration < 3; ++iteration)
+    {
+        Rectangle from = {position.x - playerSize/2, position.y - playerSize/2, playerSize, playerSize};
+        Rectangle bounds = sweptBounds(from, delta);
+
+        float toi = 1;
+        Vector2 normal = {0, 0};
+        index.platforms.query(bounds, nearby);
+        for (int i : nearby)
+        {
+            float t;
+            Vector2 n;
+            if (sweepRects(from, delta, index.platformRects.get(i), t, n) && t < toi)
+            {
+                toi = t;
+                normal = n;
+            }
+        }
+
+        index.spikes.query(bounds, nearby);
+        for (int i : nearby)
+        {
+            float t;
+            Vector2 n;
+            if (sweepRects(from, delta, index.spikeRects.get(i), t, n) && t <= toi)
+            {
+                respawn();
+                return;
+            }
+        }
+
+        position.x += delta.x * toi;
+        position.y += delta.y * toi;
+        if (toi >= 1) return;
+
+        // slide along the face for the rest of the step
+        delta = {delta.x * (1 - toi), delta.y * (1 - toi)};
+        if (normal.x != 0)
+        {
+            xVelocity = 0;
+            delta.x = 0;
+        }
+        else
+        {
+            yVelocity = 0;
+            delta.y = 0;
+            if (normal.y < 0) landed = true;
+        }
+    }
+}
+
+void Player::jump()
+{
+    if (canJump)
+    {
+        yVelocity = -jumpForce;
+        canJump = false;
+    }
+}
+
+void Player::attach(Vector2 hookPoint)
+{
+    anchor = hookPoint;
+
+    Vector2 diff = Vector2Subtract(position, anchor);
+    ropeLength = Vector2Length(diff);
+    ropeAngle = atan2f(diff.y, diff.x);
+
+    if (ropeLength != 0)
+    {
+        Vector2 tangent = { -diff.y / ropeLength, diff.x / ropeLength };
+        angularVelocity = (xVelocity * tangent.x + yVelocity * tangent.y) / ropeLength;
+    }
+
+    swinging = true;
+}
+
+// Lets go of the rope keeping the swing's tangential speed, which is returned
+float Player::releaseRope()
+{
+    float speed = 0;
+    if (swinging)
+    {
+        Vector2 toPlayer = Vector2Subtract(position, anchor);
+        float len = Vector2Length(toPlayer);
+
+        if (len != 0)
+        {
+            Vector2 tangent = { -toPlayer.y / len, toPlayer.x / len };
+
+            speed = angularVelocity * ropeLength;
+            xVelocity = tangent.x * speed / 35;
+            yVelocity = tangent.y * speed;
+        }
+    }
+
+    swinging = false;
+    return speed;
+}
+
+void Player::respawn()
+{
+    position = spawnPoint;
+    xVelocity = 0;
+    yVelocity = 0;
+    swinging = false;
+    respawned = true;
+}
+
+StepEvents Simulation::step(const InputState& input, float deltaTime)
+{
+    return stepPlayer(player, input, deltaTime);
+}
+
+// Advances p by one step against this level. Only reads the level, so any number
+// of players can be stepped against one Simulation concurrently.
+StepEvents Simulation::stepPlayer(Player& p, const InputState& input, float deltaTime) const
+{
+    if (deterministic) return stepPlayerFixed(p, input, deltaTime);
+
+    StepEvents events;
+
+    p.direction = input.direction;
+    p.respawned = false;
+    if (input.reset) p.respawn();
+    if (input.jump) p.jump();
+
+    if (input.hook)
+    {
+        // the hook flies towards the target and catches on the first platform in its way
+        RayHit hit;
+        if (raycast(p.position, Vector2Subtract(input.hookTarget, p.position), hookRange, hit))
+        {
+            p.attach(hit.point);
+            events.hooked = true;
+        }
+    }
+
+    if (input.release)
+    {
+        events.released = p.swinging;
+        events.releaseSpeed = p.releaseRope();
+    }
+
+    p.update(collision, deltaTime);
+
+    if (p.position.y > killHeight)
+    {
+        p.respawn();
+        events.fellOut = true;
+    }
+    events.died = p.respawned;
+
+    Rectangle playerRect = {
+        p.position.x - playerSize / 2,
+        p.position.y - playerSize / 2,
+        playerSize, playerSize
+    };
+
+    for (int base = 0; base < collision.endRects.count; base += overlapLanes)
+    {
+        unsigned mask = overlapMask(collision.endRects, base, playerRect);
+        if (mask)
+        {
+            events.endPoint = base + __builtin_ctz(mask);
+            break;
+        }
+    }
+
+    return events;
+}
+
+// First platform hit by a ray from origin towards direction, within maxDistance
+bool Simulation::raycast(Vector2 origin, Vector2 direction, float maxDistance, RayHit &hit) const
+{
+    float len = Vector2Length(direction);
+    if (len == 0) return false;
+    direction = {direction.x / len, direction.y / len};
+    return collision.platforms.raycast(origin, direction, maxDistance, collision.platformRects, hit);
+}
+
+// --- Deterministic mode ---
+// The rules above again in fixed point. Between steps the state lives in the player's
+// float fields on grids they hold exactly: position, anchor, rope length and yVelocity
+// at 2^-8, xVelocity and angularVelocity at 2^-16, ropeAngle at 2^-20 within [-pi, pi].
+
+const Fixed unbounded = (Fixed)1 << 62;
+
+struct FixedRect
+{
+    Fixed x, y, w, h;
+};
+
+static FixedRect fixedRect(Rectangle r)
+{
+    return {toFixed(r.x), toFixed(r.y), toFixed(r.width), toFixed(r.height)};
+}
+
+static bool overlapFixed(FixedRect a, FixedRect b)
+{
+    return a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y;
+}
+
+// Ids of the rects touching area. The grid is queried with a padded float box and the
+// result trimmed exactly, so float rounding never changes the set.
+static void queryFixed(const SpatialGrid &grid, const RectSoA &rects, FixedRect area, vector<int> &out)
+{
+    grid.query({toFloat(area.x) - 1, toFloat(area.y) - 1, toFloat(area.w) + 2, toFloat(area.h) + 2}, out);
+    out.erase(remove_if(out.begin(), out.end(), [&](int i)
+    {
+        FixedRect r = fixedRect(rects.get(i));
+        return r.x > area.x + area.w || r.x + r.w < area.x || r.y > area.y + area.h || r.y + r.h < area.y;
+    }), out.end());
+}
+
+static bool sweepFixed(FixedRect a, Fixed dx, Fixed dy, FixedRect b, Fixed &toi, int &normalX, int &normalY)
+{
+    Fixed entryX, exitX, entryY, exitY;
+
+    if (dx == 0)
+    {
+        if (a.x + a.w <= b.x || a.x >= b.x + b.w) return false;
+        entryX = -unbounded;
+        exitX = unbounded;
+    }
+    else if (dx > 0)
+    {
+        entryX = fixedDiv(b.x - (a.x + a.w), dx);
+        exitX = fixedDiv(b.x + b.w - a.x, dx);
+    }
+    else
+    {
+        entryX = fixedDiv(b.x + b.w - a.x, dx);
+        exitX = fixedDiv(b.x - (a.x + a.w), dx);
+    }
+
+    if (dy == 0)
+    {
+        if (a.y + a.h <= b.y || a.y >= b.y + b.h) return false;
+        entryY = -unbounded;
+        exitY = unbounded;
+    }
+    else if (dy > 0)
+    {
+        entryY = fixedDiv(b.y - (a.y + a.h), dy);
+        exitY = fixedDiv(b.y + b.h - a.y, dy);
+    }
+    else
+    {
+        entryY = fixedDiv(b.y + b.h - a.y, dy);
+        exitY = fixedDiv(b.y - (a.y + a.h), dy);
+    }
+
+    Fixed entry = max(entryX, entryY);
+    Fixed exit = min(exitX, exitY);
+    if (entry >= exit || entry < 0 || entry > fixedOne) return false;
+
+    normalX = normalY = 0;
+    if (entryX > entryY) normalX = dx > 0 ? -1 : 1;
+    else normalY = dy > 0 ? -1 : 1;
+    toi = entry;
+    return true;
+}
+
+// Entry and exit distances of a ray along one axis through [lo, lo + size]
+static bool slabFixed(Fixed origin, Fixed dir, Fixed lo, Fixed size, Fixed &enter, Fixed &exit)
+{
+    if (dir == 0)
+    {
+        if (origin < lo || origin > lo + size) return false;
+        enter = -unbounded;
+        exit = unbounded;
+        return true;
+    }
+    Fixed t1 = fixedDiv(lo - origin, dir);
+    Fixed t2 = fixedDiv(lo + size - origin, dir);
+    enter = min(t1, t2);
+    exit = max(t1, t2);
+    return true;
+}
+
+// Player state in Q.20 for the length of one step
+struct FixedPlayer
+{
+    Player &p;
+    Fixed x, y, xVelocity, yVelocity;
+    Fixed anchorX, anchorY, ropeLength, ropeAngle, angularVelocity;
+
+    FixedPlayer(Player &player)
+        : p(player), x(toFixed(player.position.x)), y(toFixed(player.position.y)),
+          xVelocity(toFixed(player.xVelocity)), yVelocity(toFixed(player.yVelocity)),
+          anchorX(toFixed(player.anchor.x)), anchorY(toFixed(player.anchor.y)),
+          ropeLength(toFixed(player.ropeLength)), ropeAngle(toFixed(player.ropeAngle)),
+          angularVelocity(toFixed(player.angularVelocity)) {}
+
+    void store()
+    {
+        while (ropeAngle > fixedPi) ropeAngle -= 2 * fixedPi;
+        while (ropeAngle < -fixedPi) ropeAngle += 2 * fixedPi;
+
+        p.position = {toFloat(x), toFloat(y)};
+        p.xVelocity = toFloat(xVelocity, 16);
+        p.yVelocity = toFloat(yVelocity);
+        p.anchor = {toFloat(anchorX), toFloat(anchorY)};
+        p.ropeLength = toFloat(ropeLength);
+        p.ropeAngle = toFloat(ropeAngle, 20);
+        p.angularVelocity = toFloat(angularVelocity, 16);
+    }
+
+    FixedRect rect() const
+    {
+        return {x - playerSize * fixedOne / 2, y - playerSize * fixedOne / 2, playerSize * fixedOne, playerSize * fixedOne};
+    }
+
+    void respawn()
+    {
+        x = toFixed(spawnPoint.x);
+        y = toFixed(spawnPoint.y);
+        xVelocity = 0;
+        yVelocity = 0;
+        p.swinging = false;
+        p.respawned = true;
+    }
+
+    void jump()
+    {
+        if (p.canJump)
+        {
+            yVelocity = -jumpForce * fixedOne;
+            p.canJump = false;
+        }
+    }
+
+    void attach(Fixed hookX, Fixed hookY)
+    {
+        anchorX = hookX;
+        anchorY = hookY;
+
+        Fixed dx = x - anchorX, dy = y - anchorY;
+        ropeLength = fixedLength(dx, dy);
+        ropeAngle = fixedAtan2(dy, dx);
+
+        if (ropeLength != 0)
+        {
+            Fixed tx = fixedDiv(-dy, ropeLength), ty = fixedDiv(dx, ropeLength);
+            angularVelocity = fixedDiv(fixedMul(xVelocity, tx) + fixedMul(yVelocity, ty), ropeLength);
+        }
+
+        p.swinging = true;
+    }
+
+    Fixed releaseRope()
+    {
+        Fixed speed = 0;
+        if (p.swinging)
+        {
+            Fixed dx = x - anchorX, dy = y - anchorY;
+            Fixed len = fixedLength(dx, dy);
+
+            if (len != 0)
+            {
+                Fixed tx = fixedDiv(-dy, len), ty = fixedDiv(dx, len);
+
+                speed = fixedMul(angularVelocity, ropeLength);
+                xVelocity = fixedMul(tx, speed) / 35;
+                yVelocity = fixedMul(ty, speed);
+            }
+        }
+
+        p.swinging = false;
+        return speed;
+    }
+
+    void update(const CollisionIndex& index, Fixed deltaTime)
+    {
+        Fixed travel = p.swinging ? fixedMul(fixedMul(fixedAbs(angularVelocity), ropeLength), deltaTime)
+                                  : fixedMul(fixedLength(xVelocity * (Fixed)playerSpeed, yVelocity), deltaTime);
+        Fixed maxTravel = toFixed(maxStepTravel);
+        int subSteps = 1;
+        if (travel > maxTravel) subSteps = (int)min((travel + maxTravel - 1) / maxTravel, (Fixed)maxSubSteps);
+
+        for (int i = 0; i < subSteps; ++i) integrate(index, deltaTime / subSteps);
+
+        p.wasSwingingLastFrame = p.swinging;
+    }
+
+    void integrate(const CollisionIndex& index, Fixed deltaTime)
+    {
+        Fixed stepScale = deltaTime * (Fixed)referenceRate;
+        Fixed baseFriction = toFixed(friction);
+        Fixed stepFriction = fixedPow(baseFriction, stepScale);
+        Fixed stepAccel = fixedDiv(fixedMul(baseFriction, fixedOne - stepFriction), fixedMul(stepFriction, fixedOne - baseFriction));
+
+        if (p.swinging)
+        {
+            Fixed s, c;
+            fixedSinCos(ropeAngle - fixedPi / 2, s, c);
+            Fixed angularAccel = -fixedMul(fixedDiv(gravity * fixedOne, max(ropeLength, fixedOne)), s);
+
+            angularAccel -= p.direction * 2 * fixedOne;
+
+            angularVelocity += fixedMul(angularAccel, deltaTime);
+            angularVelocity = fixedMul(angularVelocity, fixedPow(toFixed(ropeDamping), stepScale));
+            ropeAngle += fixedMul(angularVelocity, deltaTime);
+
+            fixedSinCos(ropeAngle, s, c);
+            x = anchorX + fixedMul(ropeLength, c);
+            y = anchorY + fixedMul(ropeLength, s);
+        }
+        else
+        {
+            xVelocity = fixedMul(xVelocity + p.direction * stepAccel, stepFriction);
+            yVelocity += gravity * deltaTime;
+            sweepMove(index, fixedMul(xVelocity, deltaTime) * (Fixed)playerSpeed, fixedMul(yVelocity, deltaTime));
+        }
+
+        p.canJump = p.landed;
+        p.landed = false;
+
+        // platforms in index order, each tested against the player as pushed out so far
+        FixedRect playerRect = rect();
+        queryFixed(index.platforms, index.platformRects, playerRect, p.nearby);
+        for (int i : p.nearby)
+        {
+            FixedRect platRect = fixedRect(index.platformRects.get(i));
+            if (!overlapFixed(playerRect, platRect)) continue;
+
+            Fixed overlapLeft   = (playerRect.x + playerRect.w) - platRect.x;
+            Fixed overlapRight  = (platRect.x + platRect.w) - playerRect.x;
+            Fixed overlapTop    = (playerRect.y + playerRect.h) - platRect.y;
+            Fixed overlapBottom = (platRect.y + platRect.h) - playerRect.y;
+            Fixed minOverlapX = (overlapLeft < overlapRight) ? overlapLeft : -overlapRight;
+            Fixed minOverlapY = (overlapTop < overlapBottom) ? overlapTop : -overlapBottom;
+
+            if (!p.swinging)
+            {
+                if (fixedAbs(minOverlapX) < fixedAbs(minOverlapY))
+                {
+                    x -= minOverlapX;
+                    xVelocity = 0;
+                }
+                else
+                {
+                    y -= minOverlapY;
+                    yVelocity = 0;
+                    if (minOverlapY > 0) p.canJump = true;
+                }
+            }
+            else if (fixedAbs(angularVelocity) < fixedOne)
+            {
+                angularVelocity = 0;
+                p.swinging = false;
+                xVelocity = 0;
+                yVelocity = 0;
+
+                if (fixedAbs(minOverlapX) < fixedAbs(minOverlapY)) x -= minOverlapX;
+                else y -= minOverlapY;
+            }
+            else
+            {
+                angularVelocity = -angularVelocity * 95 / 100;
+            }
+
+            playerRect = rect();
+        }
+
+        queryFixed(index.spikes, index.spikeRects, playerRect, p.nearby);
+        for (int i : p.nearby)
+        {
+            if (!overlapFixed(playerRect, fixedRect(index.spikeRects.get(i)))) continue;
+            respawn();
+            playerRect = rect();
+        }
+    }
+
+    void sweepMove(const CollisionIndex& index, Fixed dx, Fixed dy)
+    {
+        for (int iteration = 0; iteration < 3; ++iteration)
+        {
+            FixedRect from = rect();
+            FixedRect bounds = {min(from.x, from.x + dx), min(from.y, from.y + dy), from.w + fixedAbs(dx), from.h + fixedAbs(dy)};
+
+            Fixed toi = fixedOne;
+            int normalX = 0, normalY = 0;
+            queryFixed(index.platforms, index.platformRects, bounds, p.nearby);
+            for (int i : p.nearby)
+            {
+                Fixed t;
+                int nx, ny;
+                if (sweepFixed(from, dx, dy, fixedRect(index.platformRects.get(i)), t, nx, ny) && t < toi)
+                {
+                    toi = t;
+                    normalX = nx;
+                    normalY = ny;
+                }
+            }
+
+            queryFixed(index.spikes, index.spikeRects, bounds, p.nearby);
+            for (int i : p.nearby)
+            {
+                Fixed t;
+                int nx, ny;
+                if (sweepFixed(from, dx, dy, fixedRect(index.spikeRects.get(i)), t, nx, ny) && t <= toi)
+                {
+                    respawn();
+                    return;
+                }
+            }
+
+            x += fixedMul(dx, toi);
+            y += fixedMul(dy, toi);
+            if (toi >= fixedOne) return;
+
+            dx = fixedMul(dx, fixedOne - toi);
+            dy = fixedMul(dy, fixedOne - toi);
+            if (normalX != 0)
+            {
+                xVelocity = 0;
+                dx = 0;
+            }
+            else
+            {
+                yVelocity = 0;
+                dy = 0;
+                if (normalY < 0) p.landed = true;
+            }
+        }
+    }
+};
+
+// First platform hit by the hook from (x, y) towards (dx, dy). Hooks are rare, so every
+// platform near the whole segment is tested instead of walking the grid.
+static bool raycastFixed(const CollisionIndex& index, Fixed x, Fixed y, Fixed dx, Fixed dy, Fixed &hitX, Fixed &hitY, vector<int> &nearby)
+{
+    Fixed len = fixedLength(dx, dy);
+    if (len == 0) return false;
+    Fixed ux = fixedDiv(dx, len), uy = fixedDiv(dy, len);
+    Fixed range = toFixed(hookRange);
+    Fixed endX = x + fixedMul(ux, range), endY = y + fixedMul(uy, range);
+
+    queryFixed(index.platforms, index.platformRects, {min(x, endX), min(y, endY), fixedAbs(endX - x), fixedAbs(endY - y)}, nearby);
+    Fixed best = range + 1;
+    for (int i : nearby)
+    {
+        FixedRect r = fixedRect(index.platformRects.get(i));
+        Fixed enterX, exitX, enterY, exitY;
+        if (!slabFixed(x, ux, r.x, r.w, enterX, exitX) || !slabFixed(y, uy, r.y, r.h, enterY, exitY)) continue;
+
+        Fixed enter = max(enterX, enterY);
+        Fixed exit = min(exitX, exitY);
+        if (exit < enter || enter < 0 || enter >= best) continue;
+        best = enter;
+    }
+
+    if (best > range) return false;
+    hitX = x + fixedMul(ux, best);
+    hitY = y + fixedMul(uy, best);
+    return true;
+}
+
+StepEvents Simulation::stepPlayerFixed(Player& p, const InputState& input, float deltaTime) const
+{
+    StepEvents events;
+    FixedPlayer f(p);
+    Fixed dt = toFixed(deltaTime);
+
+    p.direction = input.direction;
+    p.respawned = false;
+    if (input.reset) f.respawn();
+    if (input.jump) f.jump();
+
+    if (input.hook)
+    {
+        Fixed hitX, hitY;
+        if (raycastFixed(collision, f.x, f.y, toFixed(input.hookTarget.x) - f.x, toFixed(input.hookTarget.y) - f.y, hitX, hitY, p.nearby))
+        {
+            f.attach(hitX, hitY);
+            events.hooked = true;
+        }
+    }
+
+    if (input.release)
+    {
+        events.released = p.swinging;
+        events.releaseSpeed = toFloat(f.releaseRope());
+    }
+
+    f.update(collision, dt);
+
+    if (f.y > toFixed(killHeight))
+    {
+        f.respawn();
+        events.fellOut = true;
+    }
+    events.died = p.respawned;
+
+    FixedRect playerRect = f.rect();
+    for (int i = 0; i < collision.endRects.count; ++i)
+    {
+        if (overlapFixed(playerRect, fixedRect(collision.endRects.get(i))))
+        {
+            events.endPoint = i;
+            break;
+        }
+    }
+
+    f.store();
+    return events;
+}
+
+void Simulation::rebuildCollision()
+{
+    collision.rebuild(platforms, spikes, endPoints);
+}
+
+void Simulation::compileCollision()
+{
+    if (bakeGeometry) collision.bake(platforms, spikes, endPoints);
+    else collision.rebuild(platforms, spikes, endPoints);
+}
+
+void Simulation::swapLevel(Simulation &other)
+{
+    std::swap(platforms, other.platforms);
+    std::swap(spikes, other.spikes);
+    std::swap(endPoints, other.endPoints);
+    std::swap(collision, other.collision);
+}
+
+// Writes content next to path and renames it over path, so the file is either the
+// old one or the new one in full, never a partial write. Each write has its own
+// temporary file, as two loads of one level may store its cache entry at once.
+static bool writeFileAtomic(const string &path, const string &content)
+{
+    static atomic<unsigned> writes{0};
+    string temporary = path + "." + to_string(writes.fetch_add(1, memory_order_relaxed)) + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(content.data(), content.size());
+        file.close();
+        if (!file)
+        {
+            remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    error_code ec;
+    filesystem::rename(temporary, path, ec);
+    if (ec)
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Appends the shortest text that reads back as exactly v
+static void putFloat(string &out, float v)
+{
+    char buf[32];
+    auto result = to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, result.ptr);
+}
+
+static void putCount(string &out, size_t n)
+{
+    char buf[24];
+    auto result = to_chars(buf, buf + sizeof(buf), n);
+    out.append(buf, result.ptr);
+}
+
+bool Simulation::saveToJson(const string &path) const
+{
+    namespace fs = filesystem;
+    fs::create_directories("levels");
+
+    // written straight into one buffer, about 60 bytes an object
+    string out;
+    out.reserve(64 * (platforms.size() + spikes.size() + endPoints.size()) + 64);
+
+    // the counts come first so loaders can reserve before the arrays
+    out += "{\n";
+    out += "  \"counts\": {\"platforms\":"; putCount(out, platforms.size());
+    out += ",\"spikes\":"; putCount(out, spikes.size());
+    out += ",\"endpoints\":"; putCount(out, endPoints.size());
+    out += "},\n";
+    out += "  \"platforms\": [\n";
+    for (size_t i = 0; i < platforms.size(); ++i)
+    {
+        const platform &p = platforms[i];
+        out += "    {\"x\":"; putFloat(out, p.position.x);
+        out += ",\"y\":"; putFloat(out, p.position.y);
+        out += ",\"w\":"; putFloat(out, p.size.x);
+        out += ",\"h\":"; putFloat(out, p.size.y);
+        out += p.visible ? ",\"visible\":true}" : ",\"visible\":false}";
+        if (i + 1 < platforms.size()) out += ',';
+        out += '\n';
+    }
+    out += "  ],\n";
+
+    out += "  \"spikes\": [\n";
+    for (size_t i = 0; i < spikes.size(); ++i)
+    {
+        const Spike &s = spikes[i];
+        out += "    {\"x\":"; putFloat(out, s.position.x);
+        out += ",\"y\":"; putFloat(out, s.position.y);
+        out += ",\"size\":"; putFloat(out, s.size);
+        out += '}';
+        if (i + 1 < spikes.size()) out += ',';
+        out += '\n';
+    }
+    out += "  ]\n";
+
+    out += "  ,\"endpoints\": [\n";
+    for (size_t i = 0; i < endPoints.size(); ++i)
+    {
+        const EndPoint &ep = endPoints[i];
+        out += "    {\"x\":"; putFloat(out, ep.position.x);
+        out += ",\"y\":"; putFloat(out, ep.position.y);
+        out += ",\"w\":"; putFloat(out, ep.size.x);
+        out += ",\"h\":"; putFloat(out, ep.size.y);
+        out += ep.goToMenu ? ",\"toMenu\":true}" : ",\"toMenu\":false}";
+        if (i + 1 < endPoints.size()) out += ',';
+        out += '\n';
+    }
+    out += "  ]\n";
+
+    out += "}\n";
+
+    return writeFileAtomic(path, out);
+}
+
+// The binary file a level converts to: levels/a.json -> levels/a.hlvl
+static string binaryLevelPath(const string &path)
+{
+    return filesystem::path(path).replace_extension(binaryLevelExtension).string();
+}
+
+bool Simulation::loadFromJson(const string &path, bool preferBinary)
+{
+    if (preferBinary)
+    {
+        namespace fs = filesystem;
+        string binary = binaryLevelPath(path);
+        error_code ec;
+        if (fs::exists(binary, ec))
+        {
+            auto binaryTime = fs::last_write_time(binary, ec);
+            auto jsonTime = fs::last_write_time(path, ec);
+            if ((ec || binaryTime >= jsonTime) && loadFromBinary(binary)) return true;
+        }
+    }
+
+    // one read of the whole file, then one pass over it
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in.is_open()) return false;
+    string content(in.tellg(), '\0');
+    in.seekg(0);
+    in.read(content.data(), content.size());
+    if (!in) return false;
+    in.close();
+
+    vector<platform> newPlats;
+    vector<Spike> newSpikes;
+    vector<EndPoint> newEnds;
+    const char *begin = content.data(), *end = content.data() + content.size();
+    bool parsed = parsePool && content.size() >= 2 * parallelChunkBytes
+                      ? parseLevelParallel(begin, end, *parsePool, newPlats, newSpikes, newEnds)
+                      : LevelParser(begin, end).parse(newPlats, newSpikes, newEnds);
+    if (!parsed) return false;
+
+    platforms = std::move(newPlats);
+    spikes = std::move(newSpikes);
+    endPoints = std::move(newEnds);
+    buildCollision(path, content.data(), content.size());
+    return true;
+}
+
+bool Simulation::streamFromJson(const string &path)
+{
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) return false;
+    error_code ec;
+    uintmax_t size = filesystem::file_size(path, ec);
+
+    // release the old level's memory before the new one arrives
+    vector<platform>().swap(platforms);
+    vector<Spike>().swap(spikes);
+    vector<EndPoint>().swap(endPoints);
+    collision = CollisionIndex();
+
+    LevelParser parser(in, ec ? SIZE_MAX : (size_t)size);
+    bool ok = parser.parse(platforms, spikes, endPoints);
+    if (!ok)
+    {
+        platforms.clear();
+        spikes.clear();
+        endPoints.clear();
+    }
+    compileCollision();
+    return ok;
+}
+
+// --- Binary levels ---
+
+static void putU32(string &out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out.push_back((char)(v >> (8 * i)));
+}
+
+static void putU64(string &out, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) out.push_back((char)(v >> (8 * i)));
+}
+
+static void putF32(string &out, float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+    putU32(out, bits);
+}
+
+bool Simulation::saveToBinary(const string &path) const
+{
+    // records are written byte by byte, so the file is little-endian on any host
+    const uint32_t sectionCount = 3;
+    string records[sectionCount];
+    for (auto &p : platforms)
+    {
+        putF32(records[0], p.position.x); putF32(records[0], p.position.y);
+        putF32(records[0], p.size.x); putF32(records[0], p.size.y);
+        putU32(records[0], p.visible ? 1 : 0);
+    }
+    for (auto &s : spikes)
+    {
+        putF32(records[1], s.position.x); putF32(records[1], s.position.y);
+        putF32(records[1], s.size);
+    }
+    for (auto &e : endPoints)
+    {
+        putF32(records[2], e.position.x); putF32(records[2], e.position.y);
+        putF32(records[2], e.size.x); putF32(records[2], e.size.y);
+        putU32(records[2], e.goToMenu ? 1 : 0);
+    }
+
+    const uint32_t types[sectionCount] = {SECTION_PLATFORMS, SECTION_SPIKES, SECTION_ENDPOINTS};
+    const uint32_t sizes[sectionCount] = {sizeof(PlatformRecord), sizeof(SpikeRecord), sizeof(EndPointRecord)};
+    const uint64_t counts[sectionCount] = {platforms.size(), spikes.size(), endPoints.size()};
+
+    string out(levelMagic, 4);
+    putU32(out, levelVersion);
+    putU32(out, sectionCount);
+    putU32(out, 0);
+
+    uint64_t offset = sizeof(LevelFileHeader) + sectionCount * sizeof(LevelSection);
+    for (uint32_t i = 0; i < sectionCount; ++i)
+    {
+        offset = (offset + 7) & ~(uint64_t)7;
+        putU32(out, types[i]);
+        putU32(out, sizes[i]);
+        putU64(out, offset);
+        putU64(out, counts[i]);
+        offset += records[i].size();
+    }
+    for (uint32_t i = 0; i < sectionCount; ++i)
+    {
+        out.resize((out.size() + 7) & ~(size_t)7, '\0');
+        out += records[i];
+    }
+
+    return writeFileAtomic(path, out);
+}
+
+bool Simulation::loadFromBinary(const string &path)
+{
+    LevelFileView view;
+    if (!view.open(path)) return false;
+
+    vector<platform> newPlats;
+    vector<Spike> newSpikes;
+    vector<EndPoint> newEnds;
+    newPlats.reserve(view.platforms.count);
+    newSpikes.reserve(view.spikes.count);
+    newEnds.reserve(view.endPoints.count);
+
+    for (size_t i = 0; i < view.platforms.count; ++i)
+    {
+        const PlatformRecord &r = view.platforms[i];
+        newPlats.emplace_back(r.x, r.y, r.w, r.h, (r.flags & 1) != 0);
+    }
+    for (size_t i = 0; i < view.spikes.count; ++i)
+    {
+        const SpikeRecord &r = view.spikes[i];
+        newSpikes.emplace_back(r.x, r.y, r.size);
+    }
+    for (size_t i = 0; i < view.endPoints.count; ++i)
+    {
+        const EndPointRecord &r = view.endPoints[i];
+        newEnds.emplace_back(r.x, r.y, r.w, r.h, (r.flags & 1) != 0);
+    }
+
+    platforms = std::move(newPlats);
+    spikes = std::move(newSpikes);
+    endPoints = std::move(newEnds);
+    buildCollision(path, (const char *)view.data(), view.size());
+    return true;
+}
+
+// --- Derived data cache ---
+
+// An entry holds the collision index built from one level file's bytes, baked or not,
+// in host byte order; a host of the other order sees a bad magic and rebuilds.
+const char cacheMagic[4] = {'H', 'K', 'D', 'C'};
+// bump whenever what is cached, or how it is built, changes
+const uint32_t cacheVersion = 3;
+
+// Hash of a level file's bytes taken a word at a time. It names cache entries and is
+// no defence against files crafted to collide.
+static uint64_t contentHash(const char *data, size_t size)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 0xff51afd7ed558ccdull;
+        h ^= h >> 32;
+    }
+    uint64_t tail = 0;
+    if (i < size) memcpy(&tail, data + i, size - i);
+    h = (h ^ tail) * 0xff51afd7ed558ccdull;
+    return h ^ (h >> 29);
+}
+
+// levels/a.json is cached as cache/a.json-<hash>.hcache
+static filesystem::path cacheDirectory(const string &levelPath)
+{
+    return filesystem::path(levelPath).parent_path().parent_path() / "cache";
+}
+
+static string cacheEntryPrefix(const string &levelPath)
+{
+    return filesystem::path(levelPath).filename().string() + "-";
+}
+
+// True for the name of any entry of the level prefix is for, and nothing else: a.json's
+// prefix also starts the entries of a level named a.json-2.json
+static bool isCacheEntry(const string &name, const string &prefix)
+{
+    const string suffix = ".hcache";
+    if (name.size() != prefix.size() + 16 + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) return false;
+    for (size_t i = prefix.size(); i < prefix.size() + 16; ++i)
+        if (!isdigit((unsigned char)name[i]) && (name[i] < 'a' || name[i] > 'f')) return false;
+    return true;
+}
+
+template <typename T>
+static void putRaw(string &out, const T &v)
+{
+    out.append((const char *)&v, sizeof(T));
+}
+
+template <typename T>
+static void putArray(string &out, const vector<T> &v)
+{
+    putRaw(out, (uint64_t)v.size());
+    if (!v.empty()) out.append((const char *)v.data(), v.size() * sizeof(T));
+}
+
+// Bounds-checked reads from an entry
+struct CacheReader
+{
+    const char *p;
+    const char *end;
+
+    template <typename T>
+    bool raw(T &v)
+    {
+        if ((size_t)(end - p) < sizeof(T)) return false;
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    bool array(vector<T> &v)
+    {
+        uint64_t count;
+        if (!raw(count) || count > (uint64_t)(end - p) / sizeof(T)) return false;
+        v.resize((size_t)count);
+        if (count) memcpy(v.data(), p, (size_t)count * sizeof(T));
+        p += count * sizeof(T);
+        return true;
+    }
+
+    bool grid(SpatialGrid::Flat &g)
+    {
+        return raw(g.cellSize) && array(g.slotKeys) && array(g.slotCells) && array(g.cellStarts) && array(g.ids);
+    }
+
+    bool rects(RectSoA &r)
+    {
+        int32_t count;
+        vector<float> x, y, w, h;
+        if (!raw(count) || count < 0 || !array(x) || !array(y) || !array(w) || !array(h)) return false;
+        if (x.size() != (size_t)count || y.size() != x.size() || w.size() != x.size() || h.size() != x.size()) return false;
+
+        // padded for this build's overlap kernel, which may be wider than the writer's
+        r.clear();
+        r.resize(count);
+        copy(x.begin(), x.end(), r.x.begin());
+        copy(y.begin(), y.end(), r.y.begin());
+        copy(w.begin(), w.end(), r.w.begin());
+        copy(h.begin(), h.end(), r.h.begin());
+        return true;
+    }
+};
+
+static void putRects(string &out, const RectSoA &r)
+{
+    putRaw(out, (int32_t)r.count);
+    putArray(out, vector<float>(r.x.begin(), r.x.begin() + r.count));
+    putArray(out, vector<float>(r.y.begin(), r.y.begin() + r.count));
+    putArray(out, vector<float>(r.w.begin(), r.w.begin() + r.count));
+    putArray(out, vector<float>(r.h.begin(), r.h.begin() + r.count));
+}
+
+static void putGrid(string &out, const SpatialGrid &grid)
+{
+    SpatialGrid::Flat g;
+    grid.flatten(g);
+    putRaw(out, g.cellSize);
+    putArray(out, g.slotKeys);
+    putArray(out, g.slotCells);
+    putArray(out, g.cellStarts);
+    putArray(out, g.ids);
+}
+
+// Restores sim's collision index from entry if it was built the way sim builds it,
+// from a level file with this hash and size holding sim's objects
+static bool readCacheEntry(const string &entry, uint64_t hash, uint64_t size, Simulation &sim)
+{
+    ifstream in(entry, ios::binary | ios::ate);
+    if (!in.is_open()) return false;
+    string content(in.tellg(), '\0');
+    in.seekg(0);
+    in.read(content.data(), content.size());
+    if (!in) return false;
+
+    CacheReader r{content.data(), content.data() + content.size()};
+    char magic[4];
+    uint32_t version, baked;
+    uint64_t entryHash, entrySize, plats, spks, ends;
+    if (!r.raw(magic) || memcmp(magic, cacheMagic, 4) != 0 || !r.raw(version) || version != cacheVersion) return false;
+    if (!r.raw(entryHash) || !r.raw(entrySize) || entryHash != hash || entrySize != size) return false;
+    if (!r.raw(baked) || baked != (sim.bakeGeometry ? 1u : 0u)) return false;
+    if (!r.raw(plats) || !r.raw(spks) || !r.raw(ends)) return false;
+    if (plats != sim.platforms.size() || spks != sim.spikes.size() || ends != sim.endPoints.size()) return false;
+
+    CollisionIndex index;
+    SpatialGrid::Flat platformGrid, spikeGrid;
+    if (!r.rects(index.platformRects) || !r.rects(index.spikeRects) || !r.rects(index.endRects) ||
+        !r.grid(platformGrid) || !r.grid(spikeGrid) || r.p != r.end) return false;
+
+    // unbaked, the index has one entry per object
+    if (!baked && ((uint64_t)index.platformRects.count != plats || (uint64_t)index.spikeRects.count != spks)) return false;
+    if ((uint64_t)index.endRects.count != ends) return false;
+    if (!index.platforms.restore(std::move(platformGrid), index.platformRects.count) ||
+        !index.spikes.restore(std::move(spikeGrid), index.spikeRects.count)) return false;
+    index.baked = baked;
+    sim.collision = std::move(index);
+    return true;
+}
+
+// Stores sim's collision index as entry, dropping the entries of older versions of the level
+static void writeCacheEntry(const string &entry, const string &levelPath, uint64_t hash, uint64_t size, const Simulation &sim)
+{
+    namespace fs = filesystem;
+    error_code ec;
+    fs::path directory = cacheDirectory(levelPath);
+    fs::create_directories(directory, ec);
+
+    string prefix = cacheEntryPrefix(levelPath);
+    string name = fs::path(entry).filename().string();
+    for (auto &old : fs::directory_iterator(directory, ec))
+    {
+        string oldName = old.path().filename().string();
+        if (oldName != name && isCacheEntry(oldName, prefix))
+            fs::remove(old.path(), ec);
+    }
+
+    string out(cacheMagic, 4);
+    putRaw(out, cacheVersion);
+    putRaw(out, hash);
+    putRaw(out, size);
+    putRaw(out, (uint32_t)(sim.collision.baked ? 1 : 0));
+    putRaw(out, (uint64_t)sim.platforms.size());
+    putRaw(out, (uint64_t)sim.spikes.size());
+    putRaw(out, (uint64_t)sim.endPoints.size());
+    putRects(out, sim.collision.platformRects);
+    putRects(out, sim.collision.spikeRects);
+    putRects(out, sim.collision.endRects);
+    putGrid(out, sim.collision.platforms);
+    putGrid(out, sim.collision.spikes);
+    writeFileAtomic(entry, out);
+}
+
+void Simulation::buildCollision(const string &levelPath, const char *data, size_t size)
+{
+    if (!useCache)
+    {
+        compileCollision();
+        return;
+    }
+
+    uint64_t hash = contentHash(data, size);
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+    string entry = (cacheDirectory(levelPath) / (cacheEntryPrefix(levelPath) + hex + ".hcache")).string();
+    if (readCacheEntry(entry, hash, size, *this)) return;
+
+    compileCollision();
+    writeCacheEntry(entry, levelPath, hash, size, *this);
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include "raylib.h"
+#include "collision.h"
+
+class ThreadPool;
+
+// Headless game core: level model, player physics and the play-mode rules.
+// Only raylib's plain types and the inline raymath helpers are used here, so the
+// simulation builds and runs without a window, input devices or audio.
+
+const int playerSize = 50;
+const float friction = .9f;
+const float ropeDamping = .995f;
+const float referenceRate = 60.0f; // damping constants above are tuned per step at this rate
+const float playerSpeed = 100;
+const int gravity = 1300;
+const int jumpForce = 600;
+const float maxStepTravel = 20.0f; // farther than this in one step and the player is sub-stepped
+const int maxSubSteps = 8;
+const float hookRange = 3000.0f;
+const float killHeight = 1000.0f;
+const Vector2 spawnPoint = {640, 360};
+
+class platform
+{
+    public:
+        Vector2 position;
+        Vector2 size;
+        int thickness = 10;
+        bool visible = true;
+
+        platform() { position = {0,0}; size = {100,20}; visible = true; }
+
+        platform(float xPos, float yPos, float width, float height, bool vis = true)
+        {
+            position = {xPos, yPos};
+            size = {width, height};
+            visible = vis;
+        }
+
+        Rectangle getRect() const
+        {
+            return Rectangle{position.x, position.y, size.x, size.y};
+        }
+};
+
+class Spike
+{
+    public:
+        Vector2 position;
+        float size;
+
+        Spike() { position = {0,0}; size = 40; }
+        Spike(float x, float y, float s = 40) { position = {x,y}; size = s; }
+
+        Rectangle getRect() const
+        {
+            return Rectangle{ position.x, position.y - size, size, size };
+        }
+};
+
+class EndPoint {
+    public:
+        Vector2 position;
+        Vector2 size;
+        bool goToMenu;
+
+        EndPoint(float x = 0, float y = 0, float w = 60, float h = 60, bool toMenu = false)
+            : position({x, y}), size({w, h}), goToMenu(toMenu) {}
+
+        Rectangle getRect() const {
+            return {position.x, position.y, size.x, size.y};
+        }
+};
+
+// Spikes only kill, so a row of identical spikes is one strip to the player: no gap
+// narrower than the player lets it touch the gap without touching a spike beside it.
+inline std::vector<Rectangle> spikeStrips(const std::vector<Spike>& spks)
+{
+    std::vector<Spike> sorted = spks;
+    std::sort(sorted.begin(), sorted.end(), [](const Spike& a, const Spike& b)
+    {
+        if (a.position.y != b.position.y) return a.position.y < b.position.y;
+        if (a.size != b.size) return a.size < b.size;
+        return a.position.x < b.position.x;
+    });
+
+    std::vector<Rectangle> strips;
+    for (size_t i = 0; i < sorted.size(); )
+    {
+        Rectangle strip = sorted[i].getRect();
+        size_t j = i + 1;
+        for (; j < sorted.size(); ++j)
+        {
+            const Spike& s = sorted[j];
+            if (s.position.y != sorted[i].position.y || s.size != sorted[i].size ||
+                s.position.x - (strip.x + strip.width) >= playerSize) break;
+            strip.width = std::max(strip.width, s.position.x + s.size - strip.x);
+        }
+        strips.push_back(strip);
+        i = j;
+    }
+    return strips;
+}
+
+// Collision-only copy of the level: a broadphase grid plus packed rectangles
+// for the overlap kernel. Rebuilt on load and kept in sync by the editor.
+// A baked index holds compiled geometry instead, whose ids no longer match the
+// level's objects; the editor works on a rebuilt one.
+struct CollisionIndex
+{
+    SpatialGrid platforms;
+    SpatialGrid spikes;
+    RectSoA platformRects;
+    RectSoA spikeRects;
+    RectSoA endRects;
+    bool baked = false;
+
+    void rebuild(const std::vector<platform>& plats, const std::vector<Spike>& spks, const std::vector<EndPoint>& ends)
+    {
+        baked = false;
+        platforms.clear();
+        spikes.clear();
+        platformRects.clear();
+        spikeRects.clear();
+        endRects.clear();
+        for (auto& p : plats) addPlatform(p);
+        for (auto& s : spks) addSpike(s);
+        for (auto& e : ends) endRects.push(e.getRect());
+    }
+
+    // Platforms compiled by mergeRects into fewer, larger rectangles covering the same
+    // area, spikes into strips first. Endpoints are kept one per object, their ids name
+    // the exit taken.
+    void bake(const std::vector<platform>& plats, const std::vector<Spike>& spks, const std::vector<EndPoint>& ends)
+    {
+        std::vector<Rectangle> solid;
+        solid.reserve(plats.size());
+        for (auto& p : plats) solid.push_back(p.getRect());
+        solid = mergeRects(solid);
+        std::vector<Rectangle> deadly = mergeRects(spikeStrips(spks));
+        baked = true;
+
+        platforms.clear();
+        spikes.clear();
+        platformRects.clear();
+        spikeRects.clear();
+        endRects.clear();
+        platformRects.resize((int)solid.size());
+        spikeRects.resize((int)deadly.size());
+        endRects.resize((int)ends.size());
+        for (size_t i = 0; i < solid.size(); ++i)
+        {
+            platformRects.set((int)i, solid[i]);
+            platforms.insert((int)i, solid[i]);
+        }
+        for (size_t i = 0; i < deadly.size(); ++i)
+        {
+            spikeRects.set((int)i, deadly[i]);
+            spikes.insert((int)i, deadly[i]);
+        }
+        for (size_t i = 0; i < ends.size(); ++i) endRects.set((int)i, ends[i].getRect());
+    }
+
+    void addPlatform(const platform& p)
+    {
+        platforms.insert(platformRects.count, p.getRect());
+        platformRects.push(p.getRect());
+    }
+
+    void movePlatform(int i, Rectangle before, const platform& p)
+    {
+        platforms.move(i, before, p.getRect());
+        platformRects.set(i, p.getRect());
+    }
+
+    void addSpike(const Spike& s)
+    {
+        spikes.insert(spikeRects.count, s.getRect());
+        spikeRects.push(s.getRect());
+    }
+
+    void moveSpike(int i, Rectangle before, const Spike& s)
+    {
+        spikes.move(i, before, s.getRect());
+        spikeRects.set(i, s.getRect());
+    }
+
+    void setEndPoint(int i, const EndPoint& e)
+    {
+        if (i == endRects.count) endRects.push(e.getRect());
+        else endRects.set(i, e.getRect());
+    }
+};
+
+// What the player asked for since the last step. hook and release are edges,
+// direction, jump and reset are held state.
+struct InputState
+{
+    int direction = 0;
+    bool jump = false;
+    bool hook = false;
+    Vector2 hookTarget = {0, 0};
+    bool release = false;
+    bool reset = false;
+};
+
+// What happened during a step, for the front-end's sounds and level transitions
+struct StepEvents
+{
+    bool hooked = false;
+    bool released = false;
+    float releaseSpeed = 0;
+    bool fellOut = false;
+    bool died = false;
+    int endPoint = -1;
+};
+
+class Player
+{
+    public:
+        Vector2 position = spawnPoint;
+        int direction = 0;
+        float xVelocity = 0;
+        float yVelocity = 0;
+        float thickness = 10;
+        bool canJump = true;
+
+        bool swinging = false;
+        Vector2 anchor = {0, 0};
+        float ropeLength = 0;
+        float ropeAngle = 0;
+        float angularVelocity = 0;
+
+        bool wasSwingingLastFrame = false;
+        bool landed = false;
+        bool respawned = false;
+
+        std::vector<int> nearby;
+        RectSoA nearbyRects;
+
+        void update(const CollisionIndex& index, float deltaTime);
+        void integrate(const CollisionIndex& index, float deltaTime);
+        void sweepMove(const CollisionIndex& index, Vector2 delta);
+        void jump();
+        void attach(Vector2 hookPoint);
+        float releaseRope();
+        void respawn();
+};
+
+class Simulation
+{
+    public:
+        Player player = Player();
+        std::vector<platform> platforms;
+        std::vector<Spike> spikes;
+        std::vector<EndPoint> endPoints;
+        CollisionIndex collision;
+
+        // Steps the player in fixed-point integer math (fixedmath.h) instead of floats, so a
+        // run gives bit-identical results on any machine and with any compiler flags.
+        // The player's float fields then only hold values on a fixed grid they store exactly.
+        bool deterministic = false;
+
+        // Keep what loading derives from a level in cache/ next to levels/, see buildCollision
+        bool useCache = true;
+        // Loaded levels collide against compiled geometry, see compileCollision
+        bool bakeGeometry = true;
+        // Large JSON levels are parsed over this pool when set, see parseLevelParallel.
+        // Not to be a pool the load itself runs on.
+        ThreadPool *parsePool = nullptr;
+
+        StepEvents step(const InputState& input, float deltaTime);
+        StepEvents stepPlayer(Player& p, const InputState& input, float deltaTime) const;
+        StepEvents stepPlayerFixed(Player& p, const InputState& input, float deltaTime) const;
+        bool raycast(Vector2 origin, Vector2 direction, float maxDistance, RayHit &hit) const;
+        // One collision entry per object, as the editor needs
+        void rebuildCollision();
+        // The index play mode uses: baked when bakeGeometry is set, else rebuildCollision's
+        void compileCollision();
+        // compileCollision for a level just read from data, the bytes of the file at
+        // levelPath: the index comes from the derived-data cache when it has an entry for
+        // those bytes, and is stored there when it does not
+        void buildCollision(const std::string &levelPath, const char *data, size_t size);
+        // Exchanges the level (objects and collision index) with other's in constant time
+        void swapLevel(Simulation &other);
+
+        bool saveToJson(const std::string &path) const;
+        // Loads the .hlvl next to path instead while it is at least as new as the JSON
+        bool loadFromJson(const std::string &path, bool preferBinary = true);
+        // Reads the JSON a chunk at a time straight into the level, for levels too big
+        // to also hold as text. The old level is dropped first, so on failure it is empty.
+        bool streamFromJson(const std::string &path);
+        bool saveToBinary(const std::string &path) const;
+        // Maps the .hlvl at path and copies its records into the level's objects
+        bool loadFromBinary(const std::string &path);
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+// Fixed set of worker threads fed from one job queue
+class ThreadPool
+{
+    public:
+        ThreadPool(int threads = 0)
+        {
+            if (threads <= 0) threads = std::max(1, (int)std::thread::hardware_concurrency());
+            for (int i = 0; i < threads; ++i)
+                workers.emplace_back([this, i] { run(i); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &w : workers) w.join();
+        }
+
+        int size() const { return (int)workers.size(); }
+
+        // Queues job to run on some worker; it receives that worker's index
+        void submit(std::function<void(int)> job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(std::move(job));
+            }
+            wake.notify_one();
+        }
+
+        // Runs body(begin, end, worker) over [0, count) in chunks of at most grain
+        // items and returns once every chunk is done. Not to be called from a worker.
+        void parallelFor(int count, int grain, const std::function<void(int, int, int)> &body)
+        {
+            if (count <= 0) return;
+            grain = std::max(1, grain);
+            int chunks = (count + grain - 1) / grain;
+
+            int remaining = chunks;
+            std::mutex doneMutex;
+            std::condition_variable done;
+
+            for (int c = 0; c < chunks; ++c)
+            {
+                int begin = c * grain;
+                int end = std::min(count, begin + grain);
+                submit([&, begin, end](int worker)
+                {
+                    body(begin, end, worker);
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    if (--remaining == 0) done.notify_one();
+                });
+            }
+
+            std::unique_lock<std::mutex> lock(doneMutex);
+            done.wait(lock, [&] { return remaining == 0; });
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void(int)>> jobs;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        void run(int index)
+        {
+            while (true)
+            {
+                std::function<void(int)> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                    if (stopping && jobs.empty()) return;
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                job(index);
+            }
+        }
+};
@@ -0,0 +1,79 @@
+// Shows what baking does to the collision geometry of levels: rectangles before and
+// after, and whether the baked platforms cover exactly the same area. Spike strips
+// also cover the gaps between spikes, too narrow for the player.
+// Build: g++ -O2 -std=c++17 -pthread tools/bake.cpp simulation.cpp mappedfile.cpp parallelload.cpp -o bake
+// Usage: bake [level.json...]   (no arguments: every levels/*.json)
+#include <cstdio>
+#include <filesystem>
+#include "../simulation.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+// Whether a and b cover the same points, sampled at the centre of every cell of the
+// grid made by both sets' edges
+static bool sameArea(const RectSoA &a, const RectSoA &b)
+{
+    vector<float> xs, ys;
+    for (const RectSoA *r : {&a, &b})
+        for (int i = 0; i < r->count; ++i)
+        {
+            Rectangle q = r->get(i);
+            if (q.width <= 0 || q.height <= 0) continue;
+            xs.push_back(q.x); xs.push_back(q.x + q.width);
+            ys.push_back(q.y); ys.push_back(q.y + q.height);
+        }
+    sort(xs.begin(), xs.end());
+    xs.erase(unique(xs.begin(), xs.end()), xs.end());
+    sort(ys.begin(), ys.end());
+    ys.erase(unique(ys.begin(), ys.end()), ys.end());
+
+    auto covers = [](const RectSoA &r, float x, float y)
+    {
+        for (int i = 0; i < r.count; ++i)
+        {
+            Rectangle q = r.get(i);
+            if (x > q.x && x < q.x + q.width && y > q.y && y < q.y + q.height) return true;
+        }
+        return false;
+    };
+    for (size_t i = 0; i + 1 < xs.size(); ++i)
+        for (size_t j = 0; j + 1 < ys.size(); ++j)
+        {
+            float x = (xs[i] + xs[i + 1]) / 2, y = (ys[j] + ys[j + 1]) / 2;
+            if (covers(a, x, y) != covers(b, x, y)) return false;
+        }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    vector<string> inputs(argv + 1, argv + argc);
+    if (inputs.empty())
+    {
+        for (auto &entry : fs::directory_iterator("levels"))
+            if (entry.is_regular_file() && entry.path().extension() == ".json") inputs.push_back(entry.path().string());
+    }
+
+    int failed = 0;
+    for (auto &in : inputs)
+    {
+        Simulation level;
+        level.useCache = false;
+        level.bakeGeometry = false;
+        if (!level.loadFromJson(in, false))
+        {
+            fprintf(stderr, "%s: could not read\n", in.c_str());
+            failed++;
+            continue;
+        }
+        CollisionIndex baked;
+        baked.bake(level.platforms, level.spikes, level.endPoints);
+        bool same = sameArea(level.collision.platformRects, baked.platformRects);
+        printf("%s: platforms %d -> %d, spikes %d -> %d%s\n", in.c_str(),
+               level.collision.platformRects.count, baked.platformRects.count,
+               level.collision.spikeRects.count, baked.spikeRects.count, same ? "" : "  AREA DIFFERS");
+        if (!same) failed++;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Builds tools/determinism with several optimisation and float flags and checks that
+# every build reports the same deterministic-mode hash. Float-mode hashes are shown
+# for comparison; they are not expected to agree.
+# Usage: tools/check_determinism.sh [steps]   (run from the game directory)
+
+CXX=${CXX:-g++}
+STEPS=${1:-14400}
+LEVELS="levels/tutorial.json levels/level1.json levels/level2.json"
+OUT=${TMPDIR:-/tmp}/hookle-determinism
+
+reference=""
+status=0
+for flags in "-O0" "-O2" "-O2 -ffast-math" "-O3 -ffast-math -march=native"; do
+    $CXX $flags -std=c++17 -pthread tools/determinism.cpp replay.cpp simulation.cpp mappedfile.cpp parallelload.cpp -o "$OUT" || exit 2
+    result=$("$OUT" "$STEPS" $LEVELS) || exit 2
+    det=$(echo "$result" | awk '/^deterministic [0-9a-f]+$/ { print $2 }')
+    flt=$(echo "$result" | awk '/^float +[0-9a-f]+$/ { print $2 }')
+    printf '%-30s deterministic %s  float %s\n' "$flags" "$det" "$flt"
+
+    if [ -z "$reference" ]; then reference=$det
+    elif [ "$det" != "$reference" ]; then status=1
+    fi
+done
+rm -f "$OUT"
+
+if [ $status -eq 0 ]; then echo "deterministic mode: identical across builds"
+else echo "deterministic mode: DIVERGED"
+fi
+exit $status
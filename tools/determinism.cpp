@@ -0,0 +1,97 @@
+// Prints a hash of every step of scripted runs through the given levels, in the
+// deterministic mode and in the float mode. Builds made with different compilers or
+// flags must agree on the deterministic hash; tools/check_determinism.sh compares
+// -O0, -O2 and -ffast-math builds.
+// Build: g++ -O2 -std=c++17 -pthread tools/determinism.cpp replay.cpp simulation.cpp mappedfile.cpp parallelload.cpp -o determinism
+// Usage: determinism [steps] <level.json>...
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "../replay.h"
+
+using namespace std;
+
+// Input is drawn from an integer generator and hook targets are integer offsets,
+// so every build feeds the simulation the same input.
+struct Script
+{
+    uint32_t state = 0x9e3779b9;
+
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    InputState input(int step, const Player &p, InputState held)
+    {
+        InputState in = held;
+        in.hook = false;
+        in.release = false;
+        if (step % 30 == 0)
+        {
+            in.direction = (int)(next() % 3) - 1;
+            in.jump = next() % 4 == 0;
+        }
+        uint32_t roll = next() % 120;
+        if (roll == 0)
+        {
+            in.hook = true;
+            in.hookTarget = {p.position.x + (float)((int)(next() % 801) - 400), p.position.y - (float)(next() % 600)};
+        }
+        else if (roll == 1) in.release = true;
+        in.reset = next() % 3000 == 0;
+        return in;
+    }
+};
+
+static uint64_t run(Simulation &sim, const char *level, int steps)
+{
+    sim.loadFromJson(level);
+    sim.player = Player();
+
+    Script script;
+    InputState held;
+    uint64_t h = 0;
+    for (int i = 0; i < steps; ++i)
+    {
+        held = script.input(i, sim.player, held);
+        sim.step(held, 1.0f / 120);
+        h = (h ^ playerStateHash(sim.player)) * 1099511628211ull;
+    }
+    return h;
+}
+
+int main(int argc, char **argv)
+{
+    int first = 1;
+    int steps = 120 * 120;
+    if (argc > 1 && atoi(argv[1]) > 0)
+    {
+        steps = atoi(argv[1]);
+        first = 2;
+    }
+    if (first >= argc)
+    {
+        fprintf(stderr, "usage: %s [steps] <level.json>...\n", argv[0]);
+        return 2;
+    }
+
+    uint64_t total[2] = {0, 0};
+    for (int mode = 1; mode >= 0; --mode)
+    {
+        Simulation sim;
+        sim.deterministic = mode;
+        for (int i = first; i < argc; ++i)
+        {
+            uint64_t h = run(sim, argv[i], steps);
+            printf("%-13s %s %016llx\n", mode ? "deterministic" : "float", argv[i], (unsigned long long)h);
+            total[mode] = (total[mode] ^ h) * 1099511628211ull;
+        }
+    }
+    printf("deterministic %016llx\n", (unsigned long long)total[1]);
+    printf("float         %016llx\n", (unsigned long long)total[0]);
+    return 0;
+}
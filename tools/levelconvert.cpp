@@ -0,0 +1,47 @@
+// Converts JSON levels to the binary .hlvl format the game loads in their place.
+// Build: g++ -O2 -std=c++17 -pthread tools/levelconvert.cpp simulation.cpp mappedfile.cpp parallelload.cpp -o levelconvert
+// Usage: levelconvert [level.json...]   (no arguments: every levels/*.json)
+//
+// Levels are read a chunk at a time, so ones too big to load twice convert too.
+// The game keeps using a .hlvl only while it is at least as new as its JSON, so
+// re-run this after editing levels.
+#include <cstdio>
+#include <filesystem>
+#include "../simulation.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+int main(int argc, char **argv)
+{
+    vector<string> inputs(argv + 1, argv + argc);
+    if (inputs.empty())
+    {
+        for (auto &entry : fs::directory_iterator("levels"))
+            if (entry.is_regular_file() && entry.path().extension() == ".json") inputs.push_back(entry.path().string());
+    }
+
+    int failed = 0;
+    for (auto &in : inputs)
+    {
+        string out = fs::path(in).replace_extension(".hlvl").string();
+
+        Simulation level;
+        Simulation check;
+        if (!level.streamFromJson(in))
+        {
+            fprintf(stderr, "%s: could not read\n", in.c_str());
+            failed++;
+            continue;
+        }
+        if (!level.saveToBinary(out) || !check.loadFromBinary(out))
+        {
+            fprintf(stderr, "%s: could not write %s\n", in.c_str(), out.c_str());
+            failed++;
+            continue;
+        }
+        printf("%s -> %s (%zu platforms, %zu spikes, %zu endpoints, %ju bytes)\n", in.c_str(), out.c_str(),
+               level.platforms.size(), level.spikes.size(), level.endPoints.size(), (uintmax_t)fs::file_size(out));
+    }
+    return failed ? 1 : 0;
+}
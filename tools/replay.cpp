@@ -0,0 +1,51 @@
+// Re-simulates a recorded session headless, as fast as the CPU allows, and checks that
+// every level ends in exactly the state it was recorded in.
+// Build: g++ -O2 -std=c++17 -pthread tools/replay.cpp replay.cpp simulation.cpp mappedfile.cpp parallelload.cpp -o replay
+// Usage: replay <file.replay> [repeat]
+//
+// Run it from the game directory, level paths in the replay are relative to it.
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include "../replay.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file.replay> [repeat]\n", argv[0]);
+        return 2;
+    }
+    int repeat = argc > 2 ? max(1, atoi(argv[2])) : 1;
+
+    Replay replay;
+    if (!replay.load(argv[1]))
+    {
+        fprintf(stderr, "could not read %s\n", argv[1]);
+        return 2;
+    }
+
+    uint64_t steps = replay.totalSteps();
+    double recorded = (double)steps / replay.simulationRate;
+    printf("%s: %zu levels, %llu steps at %d Hz (%.2f s of play)\n", argv[1], replay.segments.size(),
+           (unsigned long long)steps, replay.simulationRate, recorded);
+
+    Simulation sim;
+    string error;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+        if (!playReplay(replay, sim, &error))
+        {
+            printf("FAILED: %s\n", error.c_str());
+            return 1;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / repeat;
+
+    printf("identical final state %016llx\n", (unsigned long long)playerStateHash(sim.player));
+    printf("%.3f ms per playback, %.0fx real time\n", seconds * 1000, recorded / seconds);
+    return 0;
+}
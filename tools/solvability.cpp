@@ -0,0 +1,315 @@
+// Checks that a level's endpoint can be reached from the spawn point by searching
+// over input sequences with the headless simulation.
+// Build: g++ -O2 -std=c++17 -pthread tools/solvability.cpp simulation.cpp mappedfile.cpp parallelload.cpp batch.cpp -o solvability
+// Usage: solvability <level.json> [threads] [maxActions] [beamWidth]
+//
+// The search is breadth-first over macro actions (an input held for actionSteps steps),
+// so the first solution found uses the fewest actions. Each layer is expanded in
+// parallel and states are deduplicated by a hash of their quantized physics state.
+// Layers wider than beamWidth keep only the states closest to the endpoint; the
+// answer is then still a valid route but no longer guaranteed to be the fastest.
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <unordered_set>
+#include <mutex>
+#include <numeric>
+#include <algorithm>
+#include "../batch.h"
+
+using namespace std;
+
+const float fixedStep = 1.0f / 120;
+const int actionSteps = 15;
+const int hookAngles = 9;
+const float hookAimDistance = 600.0f;
+
+struct Action
+{
+    int direction;
+    bool jump;
+    bool hook;
+    float aimAngle;
+    bool release;
+};
+
+vector<Action> buildActions()
+{
+    vector<Action> actions;
+    for (int dir = -1; dir <= 1; ++dir)
+    {
+        actions.push_back({dir, false, false, 0, false});
+        actions.push_back({dir, true, false, 0, false});
+        actions.push_back({dir, false, false, 0, true});
+    }
+    // hooks are aimed at evenly spaced angles across the upper half plane
+    for (int i = 0; i < hookAngles; ++i)
+    {
+        float angle = -PI * (i + 0.5f) / hookAngles;
+        actions.push_back({0, false, true, angle, false});
+    }
+    return actions;
+}
+
+string describe(const Action &a)
+{
+    char buf[64];
+    if (a.hook) snprintf(buf, sizeof(buf), "hook %.0f deg", -a.aimAngle * RAD2DEG);
+    else snprintf(buf, sizeof(buf), "%s%s%s", a.direction < 0 ? "left" : a.direction > 0 ? "right" : "idle",
+                  a.jump ? "+jump" : "", a.release ? "+release" : "");
+    return buf;
+}
+
+uint64_t mix(uint64_t h, int64_t v)
+{
+    h ^= (uint64_t)v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+// Quantized physics state; players closer than these buckets count as the same state
+uint64_t stateHash(const PlayerBatch &b, int i)
+{
+    uint64_t h = mix(0, b.swinging[i]);
+    h = mix(h, (int64_t)floorf(b.x[i] / 8));
+    h = mix(h, (int64_t)floorf(b.y[i] / 8));
+    if (b.swinging[i])
+    {
+        h = mix(h, (int64_t)floorf(b.anchorX[i] / 16));
+        h = mix(h, (int64_t)floorf(b.anchorY[i] / 16));
+        h = mix(h, (int64_t)floorf(b.angularVelocity[i] / 0.25f));
+    }
+    else
+    {
+        h = mix(h, (int64_t)floorf(b.xVelocity[i] / 1.0f));
+        h = mix(h, (int64_t)floorf(b.yVelocity[i] / 60.0f));
+        h = mix(h, b.canJump[i]);
+    }
+    return h;
+}
+
+// Visited set split into shards so workers rarely wait on each other
+class VisitedSet
+{
+    public:
+        bool insert(uint64_t h)
+        {
+            Shard &s = shards[h % shardCount];
+            lock_guard<mutex> lock(s.lock);
+            return s.hashes.insert(h).second;
+        }
+
+    private:
+        static const int shardCount = 64;
+        struct Shard
+        {
+            mutex lock;
+            unordered_set<uint64_t> hashes;
+        };
+        Shard shards[shardCount];
+};
+
+void copyState(const PlayerBatch &from, int i, PlayerBatch &to, int j)
+{
+    to.x[j] = from.x[i]; to.y[j] = from.y[i];
+    to.xVelocity[j] = from.xVelocity[i]; to.yVelocity[j] = from.yVelocity[i];
+    to.anchorX[j] = from.anchorX[i]; to.anchorY[j] = from.anchorY[i];
+    to.ropeLength[j] = from.ropeLength[i]; to.ropeAngle[j] = from.ropeAngle[i];
+    to.angularVelocity[j] = from.angularVelocity[i];
+    to.swinging[j] = from.swinging[i]; to.canJump[j] = from.canJump[i];
+}
+
+// Distance from a state to the nearest endpoint, for trimming wide layers
+float endpointDistance(const Simulation &level, const PlayerBatch &b, int i)
+{
+    float best = INFINITY;
+    for (auto &ep : level.endPoints)
+    {
+        float dx = ep.position.x + ep.size.x / 2 - b.x[i];
+        float dy = ep.position.y + ep.size.y / 2 - b.y[i];
+        best = fminf(best, sqrtf(dx * dx + dy * dy));
+    }
+    return best;
+}
+
+struct Layer
+{
+    PlayerBatch states;
+    vector<int> parent;
+    vector<uint8_t> action;
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        cerr << "usage: solvability <level.json> [threads] [maxActions] [beamWidth]" << endl;
+        return 2;
+    }
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+    int maxActions = argc > 3 ? atoi(argv[3]) : 400;
+    int beamWidth = argc > 4 ? atoi(argv[4]) : 5000;
+
+    Simulation level;
+    if (!level.loadFromJson(argv[1]))
+    {
+        cerr << "could not load " << argv[1] << endl;
+        return 2;
+    }
+    if (level.endPoints.empty())
+    {
+        cout << "level has no endpoint" << endl;
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    vector<Action> actions = buildActions();
+    VisitedSet visited;
+    vector<Player> scratch(pool.size());
+
+    vector<Layer> layers(1);
+    layers[0].states.resize(1);
+    layers[0].parent.push_back(-1);
+    layers[0].action.push_back(0);
+    visited.insert(stateHash(layers[0].states, 0));
+
+    auto t0 = chrono::steady_clock::now();
+    long explored = 1;
+    bool trimmed = false;
+    int foundParent = -1, foundAction = -1;
+
+    for (int depth = 0; depth < maxActions && foundParent < 0; ++depth)
+    {
+        Layer &current = layers.back();
+        int count = current.states.size();
+        if (count == 0) break;
+
+        vector<Layer> produced(pool.size());
+        vector<int> found(pool.size(), -1);
+
+        pool.parallelFor(count, 64, [&](int begin, int end, int worker)
+        {
+            Player &p = scratch[worker];
+            Layer &out = produced[worker];
+            for (int i = begin; i < end; ++i)
+            {
+                for (int a = 0; a < (int)actions.size(); ++a)
+                {
+                    const Action &act = actions[a];
+                    bool swinging = current.states.swinging[i];
+                    if ((act.hook || act.jump) && swinging) continue;
+                    if (act.release && !swinging) continue;
+
+                    current.states.load(i, p);
+                    bool reached = false, died = false;
+                    for (int s = 0; s < actionSteps && !reached && !died; ++s)
+                    {
+                        InputState input;
+                        input.direction = act.direction;
+                        input.jump = act.jump;
+                        input.hook = act.hook && s == 0;
+                        input.hookTarget = {p.position.x + cosf(act.aimAngle) * hookAimDistance,
+                                            p.position.y + sinf(act.aimAngle) * hookAimDistance};
+                        input.release = act.release && s == 0;
+
+                        StepEvents e = level.stepPlayer(p, input, fixedStep);
+                        reached = e.endPoint >= 0 && !e.died;
+                        died = e.died;
+                    }
+                    if (died) continue;
+
+                    if (reached)
+                    {
+                        int key = i * (int)actions.size() + a;
+                        if (found[worker] < 0 || key < found[worker]) found[worker] = key;
+                        continue;
+                    }
+
+                    int j = out.states.size();
+                    out.states.resize(j + 1);
+                    out.states.store(j, p);
+                    if (!visited.insert(stateHash(out.states, j)))
+                    {
+                        out.states.resize(j);
+                        continue;
+                    }
+                    out.parent.push_back(i);
+                    out.action.push_back((uint8_t)a);
+                }
+            }
+        });
+
+        for (int key : found)
+        {
+            if (key >= 0 && (foundParent < 0 || key < foundParent * (int)actions.size() + foundAction))
+            {
+                foundParent = key / (int)actions.size();
+                foundAction = key % (int)actions.size();
+            }
+        }
+
+        // gather the workers' output, trimmed to the beam if the layer is too wide
+        vector<pair<int, int>> order;
+        vector<float> distance;
+        for (int w = 0; w < (int)produced.size(); ++w)
+        {
+            for (int i = 0; i < produced[w].states.size(); ++i)
+            {
+                order.push_back({w, i});
+                distance.push_back(endpointDistance(level, produced[w].states, i));
+            }
+        }
+        explored += order.size();
+
+        if ((int)order.size() > beamWidth)
+        {
+            vector<int> rank(order.size());
+            iota(rank.begin(), rank.end(), 0);
+            nth_element(rank.begin(), rank.begin() + beamWidth, rank.end(),
+                        [&](int a, int b) { return distance[a] < distance[b]; });
+            rank.resize(beamWidth);
+            sort(rank.begin(), rank.end());
+            vector<pair<int, int>> kept;
+            for (int r : rank) kept.push_back(order[r]);
+            order = move(kept);
+            trimmed = true;
+        }
+
+        Layer next;
+        next.states.resize((int)order.size());
+        for (int j = 0; j < (int)order.size(); ++j)
+        {
+            Layer &l = produced[order[j].first];
+            int i = order[j].second;
+            copyState(l.states, i, next.states, j);
+            next.parent.push_back(l.parent[i]);
+            next.action.push_back(l.action[i]);
+        }
+        layers.push_back(move(next));
+
+        fprintf(stderr, "\rdepth %d: %d states, %ld explored", depth + 1, layers.back().states.size(), explored);
+    }
+    fprintf(stderr, "\n");
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    if (foundParent < 0)
+    {
+        printf("endpoint NOT reached within %d actions: %ld states explored in %.2f s on %d threads\n",
+               (int)layers.size() - 1, explored, seconds, pool.size());
+        return 1;
+    }
+
+    // walk the parents back from the layer the solution left from
+    vector<int> path = {foundAction};
+    int layerIndex = (int)layers.size() - 2;
+    for (int i = foundParent; layerIndex > 0; i = layers[layerIndex].parent[i], --layerIndex)
+        path.push_back(layers[layerIndex].action[i]);
+
+    printf("endpoint reached in %d actions (%.2f s of play%s): %ld states explored in %.2f s on %d threads\n",
+           (int)path.size(), path.size() * actionSteps * fixedStep, trimmed ? ", beam-limited so possibly not the fastest" : "",
+           explored, seconds, pool.size());
+    for (int k = (int)path.size() - 1; k >= 0; --k) printf("  %s\n", describe(actions[path[k]]).c_str());
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+
+// Hands the latest value from one producer thread to one consumer thread without
+// locks or waiting. Three slots: the producer fills its own and publishes it by
+// swapping it with the shared middle one, the consumer takes the middle one when it is
+// newer than its own. Values published between two takes are skipped.
+template <typename T>
+class TripleBuffer
+{
+    public:
+        // The producer's slot, to fill before publish()
+        T &back() { return slots[backIndex]; }
+
+        void publish()
+        {
+            backIndex = middle.exchange(backIndex | fresh, std::memory_order_acq_rel) & indexMask;
+        }
+
+        // Makes the newest published value current, if one came since the last call
+        bool update()
+        {
+            if (!(middle.load(std::memory_order_relaxed) & fresh)) return false;
+            frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+            return true;
+        }
+
+        // The consumer's current value
+        const T &front() const { return slots[frontIndex]; }
+
+    private:
+        static const int indexMask = 3;
+        static const int fresh = 4;
+
+        T slots[3] = {};
+        int backIndex = 0;
+        int frontIndex = 1;
+        std::atomic<int> middle{2};
+};